@@ -4,6 +4,9 @@
 #ifndef SPAIX_CONFIG_HPP
 #define SPAIX_CONFIG_HPP
 
+#include <spaix/NullObserver.hpp>
+#include <spaix/NullSummary.hpp>
+#include <spaix/ReinsertUnderflow.hpp>
 #include <spaix/types.hpp>
 
 #include <algorithm>
@@ -67,16 +70,34 @@ struct StaticStructure {
    multiplied by the maximum fanout, gives the minimum number of children that
    a non-root directory node can have.  For example, the default value of 3/10
    means that nodes have at least 3/10th of the maximum fanout.
+
+   @tparam TreeObserver Observer which is notified when items are inserted,
+   erased, or relocated, like spaix::Subscriptions.  The default
+   spaix::NullObserver ignores all events.
+
+   @tparam DataSummary Summary of data attributes stored in every directory
+   node, which predicates can use to skip subtrees.  The default
+   spaix::NullSummary stores nothing.
+
+   @tparam UnderflowPolicy Handling of nodes that become under-filled after
+   erasure.  The default spaix::ReinsertUnderflow reinserts their children,
+   and spaix::MergeUnderflow merges them with a sibling instead.
 */
 template<class TreeStructure,
          class SplitAlgorithm,
          class InsertionAlgorithm,
-         class MinFillRatio = DefaultMinFillRatio>
+         class MinFillRatio    = DefaultMinFillRatio,
+         class TreeObserver    = NullObserver,
+         class DataSummary     = NullSummary,
+         class UnderflowPolicy = ReinsertUnderflow>
 struct Config {
   using Structure = TreeStructure;
   using Split     = SplitAlgorithm;
   using Insertion = InsertionAlgorithm;
   using MinFill   = typename MinFillRatio::type;
+  using Observer  = TreeObserver;
+  using Summary   = DataSummary;
+  using Underflow = UnderflowPolicy;
 
   static_assert(MinFillRatio::num < MinFillRatio::den);
 
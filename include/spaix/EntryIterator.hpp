@@ -75,6 +75,13 @@ public:
     return _parents[index]->dir_children()[_indexes[index]];
   }
 
+  [[nodiscard]] const typename DirNode::DirEntry& at(
+    unsigned index) const noexcept
+  {
+    assert(index < _size);
+    return _parents[index]->dir_children()[_indexes[index]];
+  }
+
   [[nodiscard]] ChildIndex index() const noexcept
   {
     assert(_size);
@@ -83,6 +90,9 @@ public:
 
   [[nodiscard]] bool empty() const noexcept { return _size == 0; }
 
+  /// Return the number of directory nodes from the root to the entry
+  [[nodiscard]] unsigned depth() const noexcept { return _size; }
+
   void step_up() noexcept
   {
     assert(_size);
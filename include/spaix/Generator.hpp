@@ -0,0 +1,147 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_GENERATOR_HPP
+#define SPAIX_GENERATOR_HPP
+
+#ifndef SPAIX_NO_COROUTINES
+#  define SPAIX_USE_COROUTINES __cplusplus >= 202002L
+#endif
+
+#if SPAIX_USE_COROUTINES
+
+#  include <coroutine>
+#  include <cstddef>
+#  include <exception>
+#  include <iterator>
+#  include <utility>
+
+namespace spaix {
+
+/**
+   A lazy sequence of values produced by a coroutine.
+
+   This is a minimal move-only generator which yields references to values
+   that live in the coroutine frame, so nothing is copied or allocated per
+   value.  A yielded reference is only valid until the generator is resumed,
+   which happens when the iterator is incremented.
+*/
+template<class Value>
+class Generator
+{
+public:
+  struct promise_type {
+    Generator get_return_object() noexcept
+    {
+      return Generator{Handle::from_promise(*this)};
+    }
+
+    static std::suspend_always initial_suspend() noexcept { return {}; }
+    static std::suspend_always final_suspend() noexcept { return {}; }
+
+    std::suspend_always yield_value(const Value& value) noexcept
+    {
+      _value = &value;
+      return {};
+    }
+
+    static void return_void() noexcept {}
+    static void unhandled_exception() noexcept { std::terminate(); }
+
+    const Value* _value{}; ///< Most recently yielded value
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  /// Iterator sentinel
+  struct Sentinel {};
+
+  /// Input iterator that resumes the coroutine when incremented
+  class Iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = Value;
+    using pointer           = const Value*;
+    using reference         = const Value&;
+
+    explicit Iterator(Handle handle) noexcept
+      : _handle{handle}
+    {}
+
+    [[nodiscard]] const Value& operator*() const noexcept
+    {
+      return *_handle.promise()._value;
+    }
+
+    [[nodiscard]] const Value* operator->() const noexcept
+    {
+      return _handle.promise()._value;
+    }
+
+    Iterator& operator++()
+    {
+      _handle.resume();
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    [[nodiscard]] bool operator==(Sentinel) const noexcept
+    {
+      return _handle.done();
+    }
+
+  private:
+    Handle _handle;
+  };
+
+  explicit Generator(Handle handle) noexcept
+    : _handle{handle}
+  {}
+
+  Generator(const Generator&)            = delete;
+  Generator& operator=(const Generator&) = delete;
+
+  Generator(Generator&& other) noexcept
+    : _handle{std::exchange(other._handle, {})}
+  {}
+
+  Generator& operator=(Generator&& other) noexcept
+  {
+    if (this != &other) {
+      destroy();
+      _handle = std::exchange(other._handle, {});
+    }
+
+    return *this;
+  }
+
+  ~Generator() { destroy(); }
+
+  /// Start the coroutine and return an iterator to the first value
+  [[nodiscard]] Iterator begin()
+  {
+    _handle.resume();
+    return Iterator{_handle};
+  }
+
+  [[nodiscard]] static Sentinel end() noexcept { return {}; }
+
+private:
+  void destroy() noexcept
+  {
+    if (_handle) {
+      _handle.destroy();
+    }
+  }
+
+  Handle _handle;
+};
+
+} // namespace spaix
+
+#endif // SPAIX_USE_COROUTINES
+
+#endif // SPAIX_GENERATOR_HPP
@@ -0,0 +1,60 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_HANDLETABLE_HPP
+#define SPAIX_HANDLETABLE_HPP
+
+#include <spaix/ItemHandle.hpp>
+#include <spaix/NullObserver.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+
+namespace spaix {
+
+/**
+   A table of the current handle of every item in a tree, by data.
+
+   This is a tree observer (see spaix::NullObserver) which keeps the handle of
+   every item up to date as items move, so an item can be found by its data,
+   for example an object ID, without a search.  The data of every item must
+   be unique, and hashable with `Hash`.
+
+   @tparam Data Data of items in the tree.
+   @tparam Hash Hash function for data.
+*/
+template<class Data, class Hash = std::hash<Data>>
+class HandleTable : public NullObserver
+{
+public:
+  /// Return the handle of the item with the given data, or null
+  [[nodiscard]] const ItemHandle* find(const Data& data) const noexcept
+  {
+    const auto i = _handles.find(data);
+
+    return i == _handles.end() ? nullptr : &i->second;
+  }
+
+  /// Return the number of items in the table
+  [[nodiscard]] size_t size() const noexcept { return _handles.size(); }
+
+  template<class DatNode>
+  void erased(const DatNode& node) noexcept
+  {
+    _handles.erase(node.second);
+  }
+
+  template<class DatNode>
+  void placed(const DatNode& node, const ItemHandle& handle)
+  {
+    _handles[node.second] = handle;
+  }
+
+private:
+  std::unordered_map<Data, ItemHandle, Hash> _handles;
+};
+
+} // namespace spaix
+
+#endif // SPAIX_HANDLETABLE_HPP
@@ -0,0 +1,28 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_ITEMHANDLE_HPP
+#define SPAIX_ITEMHANDLE_HPP
+
+#include <cstddef>
+
+namespace spaix {
+
+/**
+   The position of an item in the leaf of a tree.
+
+   Unlike an iterator, this doesn't record the path from the root, which the
+   tree can recover from parent pointers, so it is small and can be stored
+   for every item.  A handle is only valid until the item is moved to
+   another position, which happens when it is inserted or relocated, or when
+   other items are inserted or erased.  Every such move is reported to the
+   tree observer, see spaix::NullObserver::placed().
+*/
+struct ItemHandle {
+  void*  leaf{};  ///< Leaf node that contains the item
+  size_t index{}; ///< Index of the item in the leaf
+};
+
+} // namespace spaix
+
+#endif // SPAIX_ITEMHANDLE_HPP
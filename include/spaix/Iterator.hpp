@@ -6,6 +6,7 @@
 
 #include <spaix/DataIterator.hpp>
 #include <spaix/detail/entry.hpp>
+#include <spaix/detail/matches.hpp>
 #include <spaix/types.hpp>
 
 #include <cassert>
@@ -43,7 +44,7 @@ public:
     , _predicate{std::move(predicate)}
   {
     const auto& root = root_entry.node;
-    if (root && _predicate.directory(root_entry.key)) {
+    if (root && detail::dir_matches(_predicate, root_entry)) {
       const ChildIndex root_child_index = leftmost_child(*root, _predicate);
       if (root_child_index < root->num_children()) {
         this->step_down(root.get(), root_child_index);
@@ -54,7 +55,8 @@ public:
     }
 
     assert(this->empty() ||
-           _predicate.leaf(detail::entry_key(this->operator*())));
+           detail::dat_matches<DirNode>(
+             _predicate, parent()->dat_children()[index()]));
   }
 
   Iterator& operator++() noexcept
@@ -86,7 +88,7 @@ private:
   {
     if (dir.child_type() == NodeType::directory) {
       for (ChildIndex i = 0U; i < dir.num_children(); ++i) {
-        if (predicate.directory(dir.dir_children()[i].key)) {
+        if (detail::dir_matches(predicate, dir.dir_children()[i])) {
           return i;
         }
       }
@@ -94,7 +96,7 @@ private:
     }
 
     for (ChildIndex i = 0U; i < dir.dat_children().size(); ++i) {
-      if (predicate.leaf(detail::entry_key(dir.dat_children()[i]))) {
+      if (detail::dat_matches<DirNode>(predicate, dir.dat_children()[i])) {
         return i;
       }
     }
@@ -107,9 +109,9 @@ private:
     assert(parent()->child_type() == NodeType::data);
     do {
       Base::step_right();
-    } while (
-      index() < parent()->num_children() &&
-      !_predicate.leaf(detail::entry_key(parent()->dat_children()[index()])));
+    } while (index() < parent()->num_children() &&
+             !detail::dat_matches<DirNode>(_predicate,
+                                           parent()->dat_children()[index()]));
 
     return index() < parent()->num_children() ? Status::success
                                               : Status::reached_end;
@@ -122,7 +124,8 @@ private:
     do {
       Base::step_right();
     } while (index() < parent()->num_children() &&
-             !_predicate.directory(parent()->dir_children()[index()].key));
+             !detail::dir_matches(_predicate,
+                                  parent()->dir_children()[index()]));
   }
 
   /// Move up/right until we reach a node we are not at the end of yet
@@ -175,8 +178,9 @@ private:
     // Now at a matching directory, and a matching child of that directory
     assert(
       (parent()->child_type() == NodeType::directory &&
-       _predicate.directory(parent()->dir_children()[index()].key)) ||
-      (_predicate.leaf(detail::entry_key(parent()->dat_children()[index()]))));
+       detail::dir_matches(_predicate, parent()->dir_children()[index()])) ||
+      (detail::dat_matches<DirNode>(_predicate,
+                                    parent()->dat_children()[index()])));
 
     return move_down_left();
   }
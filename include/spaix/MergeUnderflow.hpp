@@ -0,0 +1,97 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_MERGEUNDERFLOW_HPP
+#define SPAIX_MERGEUNDERFLOW_HPP
+
+#include <spaix/detail/entry.hpp>
+
+#include <limits>
+#include <utility>
+
+namespace spaix {
+
+/**
+   Underflow handling by merging with, or borrowing from, a sibling.
+
+   Like in a B-tree, an under-filled node is merged into the sibling that it
+   would enlarge the least, if they fit in a single node.  Otherwise, it takes
+   the entries from that sibling that enlarge it the least until it is filled
+   enough again.  Either way, everything stays beneath the same parent, so
+   nothing is reinserted, and erasing never causes a split.
+*/
+template<typename Operations>
+class MergeUnderflow
+{
+public:
+  using Ops = Operations;
+  using Box = typename Operations::Box;
+
+  /// Choose the sibling of `children[index]` to merge with or borrow from
+  template<class Children>
+  static typename Children::size_type choose_sibling(
+    const Children&                    children,
+    const typename Children::size_type index) noexcept
+  {
+    using ChildIndex = typename Children::size_type;
+
+    const auto& key = children[index].key;
+
+    ChildIndex best_index{};
+    auto       best_cost = max_cost();
+    for (auto i = ChildIndex{}; i < children.size(); ++i) {
+      if (i != index) {
+        const auto cost = enlargement(children[i].key, key);
+        if (cost < best_cost) {
+          best_cost  = cost;
+          best_index = i;
+        }
+      }
+    }
+
+    return best_index;
+  }
+
+  /// Choose the entry to move to a node with `key` that enlarges it least
+  template<class Entries>
+  static typename Entries::size_type choose_entry(const Entries& entries,
+                                                  const Box& key) noexcept
+  {
+    using ChildIndex = typename Entries::size_type;
+
+    ChildIndex best_index{};
+    auto       best_cost = max_cost();
+    for (auto i = ChildIndex{}; i < entries.size(); ++i) {
+      const auto cost = enlargement(key, detail::entry_key(entries[i]));
+      if (cost < best_cost) {
+        best_cost  = cost;
+        best_index = i;
+      }
+    }
+
+    return best_index;
+  }
+
+private:
+  using Volume = typename Operations::Volume;
+
+  static constexpr std::pair<Volume, Volume> max_cost() noexcept
+  {
+    return {std::numeric_limits<Volume>::max(),
+            std::numeric_limits<Volume>::max()};
+  }
+
+  /// Return the volume increase and resulting volume of adding `key` to `box`
+  template<class Key>
+  static std::pair<Volume, Volume> enlargement(const Box& box,
+                                               const Key& key) noexcept
+  {
+    const auto new_volume = Ops::volume(Ops::unify(box, key));
+
+    return {new_volume - Ops::volume(box), new_volume};
+  }
+};
+
+} // namespace spaix
+
+#endif // SPAIX_MERGEUNDERFLOW_HPP
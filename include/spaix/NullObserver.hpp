@@ -0,0 +1,48 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_NULLOBSERVER_HPP
+#define SPAIX_NULLOBSERVER_HPP
+
+namespace spaix {
+
+/**
+   A tree observer that ignores every event.
+
+   An observer is notified of changes to the items in a tree, and is set with
+   the `TreeObserver` parameter of spaix::Config.  This is the default, which
+   compiles away entirely, and can be used as a base class for observers that
+   only handle some events.
+*/
+struct NullObserver {
+  /// Called after an item has been inserted
+  template<class DatNode>
+  void inserted(const DatNode&) noexcept
+  {}
+
+  /// Called after an item has been erased
+  template<class DatNode>
+  void erased(const DatNode&) noexcept
+  {}
+
+  /// Called after an item has been moved from `old_key` to its current key
+  template<class Key, class DatNode>
+  void relocated(const Key&, const DatNode&) noexcept
+  {}
+
+  /**
+     Called after an item has been placed in a new position in a leaf.
+
+     This is called whenever an item is stored somewhere new, so the given
+     handle can be used to find the item quickly later, as long as no later
+     call has been made for the same item.  When an item is inserted, this is
+     called before inserted().
+  */
+  template<class DatNode, class Handle>
+  void placed(const DatNode&, const Handle&) noexcept
+  {}
+};
+
+} // namespace spaix
+
+#endif // SPAIX_NULLOBSERVER_HPP
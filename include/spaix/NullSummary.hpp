@@ -0,0 +1,47 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_NULLSUMMARY_HPP
+#define SPAIX_NULLSUMMARY_HPP
+
+namespace spaix {
+
+/**
+   A data summary that doesn't summarize anything.
+
+   A data summary extracts a small attribute from the data of every item, so
+   that each directory node can store the union of the attributes of every
+   item beneath it.  It is set with the `DataSummary` parameter of
+   spaix::Config, and must have:
+
+   - A `Mask` type which is default-constructible (as an empty summary) and
+     supports `|=` to merge summaries, like an unsigned integer bitmask.
+
+   - A static `summarize(const Data&)` method that returns the mask for one
+     data element.
+
+   A predicate can then have a `summary(const Mask&)` method that returns
+   false if nothing with the given summary can match, and queries will skip
+   any directory whose summary doesn't match, and any item whose own summary
+   doesn't match.  A summary only shows what may be beneath a directory, so
+   such a predicate is never assumed to cover one, and methods that use
+   `covers()`, like visit_delta() and extract(), check every item beneath
+   matching directories instead.  Since summaries are computed when items are
+   inserted, the summarized attribute of an item must not be modified while
+   it is in the tree.
+
+   This is the default, which stores nothing and compiles away entirely.
+*/
+struct NullSummary {
+  struct Mask {};
+
+  template<class Data>
+  static constexpr Mask summarize(const Data&) noexcept
+  {
+    return {};
+  }
+};
+
+} // namespace spaix
+
+#endif // SPAIX_NULLSUMMARY_HPP
@@ -0,0 +1,192 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_QUERYCACHE_HPP
+#define SPAIX_QUERYCACHE_HPP
+
+#include <spaix/DataNode.hpp>
+#include <spaix/NullObserver.hpp>
+#include <spaix/search/Within.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace spaix {
+
+/// Statistics about the use of a spaix::QueryCache
+struct QueryCacheStats {
+  size_t hits{};          ///< Queries answered from the cache
+  size_t misses{};        ///< Queries answered by searching the tree
+  size_t invalidations{}; ///< Entries dropped because the tree changed
+  size_t evictions{};     ///< Entries dropped to make room for others
+  size_t memory{};        ///< Bytes allocated for cached results
+
+  /// Return the fraction of queries that were answered from the cache
+  [[nodiscard]] double hit_rate() const noexcept
+  {
+    const auto n_queries = hits + misses;
+
+    return n_queries
+             ? (static_cast<double>(hits) / static_cast<double>(n_queries))
+             : 0.0;
+  }
+};
+
+/**
+   A cache of query results that is invalidated by changes to the tree.
+
+   This is a tree observer (see spaix::NullObserver) which stores copies of
+   the results for recently queried windows.  When an item is inserted,
+   erased, or relocated, only the entries for windows that intersect its old
+   or new key are dropped.  When the cache is full, the least recently used
+   entry is evicted.
+
+   @tparam Comparisons Geometric comparisons between windows and item keys.
+   @tparam Key Key of items in the tree.
+   @tparam Data Data of items in the tree.
+   @tparam Search Search predicate constructed from a window.
+*/
+template<class Comparisons,
+         class Key,
+         class Data,
+         class Search = search::Within<Comparisons, typename Comparisons::Box>>
+class QueryCache : public NullObserver
+{
+public:
+  using Window  = typename Comparisons::Box; ///< Query area
+  using DatNode = DataNode<Key, Data>;       ///< Cached item
+  using Results = std::vector<DatNode>;      ///< Cached query results
+
+  /// Construct a cache that holds the results for up to `capacity` windows
+  explicit QueryCache(const size_t capacity) noexcept
+    : _capacity{capacity}
+  {
+    assert(capacity);
+  }
+
+  /**
+     Return the results of searching a window in a tree.
+
+     The tree must be the one this cache observes.  The returned results are
+     only valid until the next call to a non-const method of the cache.
+  */
+  template<class Tree>
+  const Results& query(const Tree& tree, const Window& window)
+  {
+    ++_clock;
+
+    for (auto& entry : _entries) {
+      if (entry.window == window) {
+        ++_stats.hits;
+        entry.last_use = _clock;
+        return entry.results;
+      }
+    }
+
+    ++_stats.misses;
+
+    Entry* entry = nullptr;
+    if (_entries.size() < _capacity) {
+      entry = &_entries.emplace_back(Entry{window, {}, _clock});
+    } else {
+      entry = &_entries.front();
+      for (auto& e : _entries) {
+        if (e.last_use < entry->last_use) {
+          entry = &e;
+        }
+      }
+
+      ++_stats.evictions;
+      entry->window   = window;
+      entry->last_use = _clock;
+      entry->results.clear();
+    }
+
+    for (const auto& node : tree.query(Search{window})) {
+      entry->results.push_back(node);
+    }
+
+    return entry->results;
+  }
+
+  /// Visit every item within a window in a tree, from the cache if possible
+  template<class Tree, class Visitor>
+  void visit_matches(const Tree& tree, const Window& window, Visitor&& visitor)
+  {
+    for (const auto& node : query(tree, window)) {
+      visitor(node);
+    }
+  }
+
+  /// Drop all cached results
+  void clear() noexcept { _entries.clear(); }
+
+  /// Return the number of windows with cached results
+  [[nodiscard]] size_t size() const noexcept { return _entries.size(); }
+
+  /// Return statistics about the use of this cache
+  [[nodiscard]] QueryCacheStats stats() const noexcept
+  {
+    QueryCacheStats stats = _stats;
+
+    stats.memory = _entries.capacity() * sizeof(Entry);
+    for (const auto& entry : _entries) {
+      stats.memory += entry.results.capacity() * sizeof(DatNode);
+    }
+
+    return stats;
+  }
+
+  template<class Node>
+  void inserted(const Node& node) noexcept
+  {
+    invalidate(node.first);
+  }
+
+  template<class Node>
+  void erased(const Node& node) noexcept
+  {
+    invalidate(node.first);
+  }
+
+  template<class OldKey, class Node>
+  void relocated(const OldKey& old_key, const Node& node) noexcept
+  {
+    invalidate(old_key);
+    invalidate(node.first);
+  }
+
+private:
+  struct Entry {
+    Window   window;
+    Results  results;
+    uint64_t last_use;
+  };
+
+  /// Drop the results for every window that intersects `key`
+  template<class ChangedKey>
+  void invalidate(const ChangedKey& key) noexcept
+  {
+    for (size_t i = 0U; i < _entries.size();) {
+      if (Comparisons::intersects(_entries[i].window, key)) {
+        std::swap(_entries[i], _entries.back());
+        _entries.pop_back();
+        ++_stats.invalidations;
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  std::vector<Entry> _entries;
+  QueryCacheStats    _stats;
+  size_t             _capacity;
+  uint64_t           _clock{};
+};
+
+} // namespace spaix
+
+#endif // SPAIX_QUERYCACHE_HPP
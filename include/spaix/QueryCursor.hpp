@@ -0,0 +1,33 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_QUERYCURSOR_HPP
+#define SPAIX_QUERYCURSOR_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace spaix {
+
+/**
+   A saved position in a query which can be resumed later.
+
+   This records the path of child indexes from the root to an item, along with
+   the version of the tree when it was saved.  Unlike an iterator, it contains
+   no pointers, so it is trivially copyable and can be stored or sent
+   elsewhere as raw bytes, for example as a pagination token.  A cursor can
+   only be resumed if the tree has not been modified since it was saved.
+*/
+template<class ChildIndex, unsigned max_height>
+struct QueryCursor {
+  /// Return true iff this is the end of a query
+  [[nodiscard]] bool empty() const noexcept { return !depth; }
+
+  uint64_t                                version{}; ///< Tree version
+  unsigned                                depth{};   ///< Path length
+  std::array<ChildIndex, max_height + 1U> indexes{}; ///< Path from root
+};
+
+} // namespace spaix
+
+#endif // SPAIX_QUERYCURSOR_HPP
@@ -0,0 +1,35 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_QUERYPROGRESS_HPP
+#define SPAIX_QUERYPROGRESS_HPP
+
+#include <spaix/StaticVector.hpp>
+
+namespace spaix {
+
+/**
+   The progress of a query that may stop before visiting every match.
+
+   This records the subtrees that a budgeted query skipped, so that a later
+   call can resume where it left off.  The skipped subtrees refer directly to
+   tree nodes, so progress is only valid until the tree is modified.
+*/
+template<class DirEntry, class Count, Count max_pending>
+struct QueryProgress {
+  /// Return true iff the query has visited every matching subtree
+  [[nodiscard]] bool complete() const noexcept
+  {
+    return started && pending.empty();
+  }
+
+  /// Subtrees that were skipped because the budget was exhausted
+  StaticVector<const DirEntry*, Count, max_pending> pending;
+
+  /// True iff the query has been started
+  bool started{};
+};
+
+} // namespace spaix
+
+#endif // SPAIX_QUERYPROGRESS_HPP
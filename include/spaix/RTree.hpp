@@ -4,9 +4,16 @@
 #ifndef SPAIX_RTREE_HPP
 #define SPAIX_RTREE_HPP
 
+#include <spaix/ConstStaticVectorView.hpp>
 #include <spaix/DataNode.hpp>
+#include <spaix/DataPlacement.hpp>
 #include <spaix/EntryIterator.hpp>
+#include <spaix/Generator.hpp>
+#include <spaix/ItemHandle.hpp>
 #include <spaix/Iterator.hpp>
+#include <spaix/NullObserver.hpp>
+#include <spaix/QueryCursor.hpp>
+#include <spaix/QueryProgress.hpp>
 #include <spaix/SplitParts.hpp>
 #include <spaix/StaticVector.hpp>
 #include <spaix/TreeRange.hpp>
@@ -16,6 +23,12 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
 
 // IWYU pragma: no_include "spaix/RTree.ipp"
 
@@ -46,11 +59,14 @@ public:
   using Structure = typename Conf::Structure; ///< Tree structure configuration
   using Insertion = typename Conf::Insertion; ///< Insertion algorithm
   using Split     = typename Conf::Split;     ///< Split algorithm
+  using Observer  = typename Conf::Observer;  ///< Change observer
+  using Summary   = typename Conf::Summary;   ///< Data summary
+  using Underflow = typename Conf::Underflow; ///< Underflow policy
   using Ops       = typename Insertion::Ops;  ///< Key operations
 
   using DatNode = DataNode<Key, Data>; ///< Leaf node
   using DirNode =
-    detail::DirectoryNode<Box, DatNode, Structure>; ///< Internal node
+    detail::DirectoryNode<Box, DatNode, Structure, Summary>; ///< Internal node
 
   using ChildCount = typename DirNode::ChildCount;
   using ChildIndex = typename DirNode::ChildCount;
@@ -81,6 +97,29 @@ public:
   /// A path of indexes to a node starting at the root
   using NodePath = StaticVector<ChildIndex, ChildCount, max_height() + 1U>;
 
+  /// The progress of a budgeted query
+  using Progress = QueryProgress<typename DirNode::DirEntry,
+                                 unsigned,
+                                 max_height() * Conf::dir_fanout>;
+
+  /// A saved position in a query
+  using Cursor = QueryCursor<ChildIndex, max_height()>;
+
+  /// An element of a contiguous batch: a data node, or a pointer to one
+  using BatchElement = std::conditional_t<DirNode::placement ==
+                                            DataPlacement::inlined,
+                                          DatNode,
+                                          const DatNode*>;
+
+  /// A contiguous batch of matches from a single leaf
+  using BatchView =
+    ConstStaticVectorView<BatchElement, ChildCount, Conf::dat_fanout>;
+
+  /// A batch of query results
+  template<unsigned batch_size>
+  using Batch =
+    StaticVector<std::reference_wrapper<const DatNode>, unsigned, batch_size>;
+
   // STL Container member types
   using iterator       = Searcher<search::Everything>;
   using const_iterator = ConstSearcher<search::Everything>;
@@ -106,6 +145,14 @@ public:
   */
   RTree(Insertion insertion, Split split) noexcept;
 
+  /**
+     Construct an RTree with the given insertion, split, and observer.
+
+     This is like the above constructor, but also moves the given observer
+     into the tree, which is needed for observers with state.
+  */
+  RTree(Insertion insertion, Split split, Observer observer) noexcept;
+
   ~RTree() = default;
 
   RTree(const RTree&)                = delete;
@@ -116,12 +163,191 @@ public:
   /// Insert a new item with the given `key` and `data`
   data_iterator insert(const Key& key, const Data& data);
 
-  /// Reinsert an existing item under a new `key`
+  /**
+     Reinsert an existing item under a new `key`.
+
+     If the new key is still within the bounds of a directory on the path to
+     the item, then the item stays where it is, and only the directory keys
+     below that one are updated.  Otherwise, it is erased and reinserted.
+     Either way, `i` points to the item afterwards.
+  */
   void relocate(data_iterator& i, const Key& key);
 
+  /// Reinsert the item at a handle under a new `key`
+  void relocate(const ItemHandle& handle, const Key& key);
+
+  /**
+     Insert a new item with room to move within `bounds`.
+
+     This is like insert(), but the directories on the path to the item are
+     enlarged to contain `bounds`, which must contain `key`.  Moves within
+     these loose bounds can then be made with the relocate() overloads that
+     take bounds, without touching any directory keys.  Typical bounds are
+     the key enlarged by some margin, or swept along the item's velocity.
+  */
+  data_iterator insert(const Key& key, const Data& data, const Box& bounds);
+
+  /**
+     Reinsert an existing item under a new `key` with loose `bounds`.
+
+     If the key of the item's leaf already contains the new key, then only the
+     item's key is written.  Otherwise, the item is relocated as usual, and
+     the directories on its new path are enlarged to contain `bounds`, which
+     must contain `key`.  Loose bounds make queries a bit slower, since
+     directories are larger than necessary, but make small movements very
+     cheap.
+  */
+  void relocate(data_iterator& i, const Key& key, const Box& bounds);
+
+  /// Reinsert the item at a handle under a new `key` with loose `bounds`
+  void relocate(const ItemHandle& handle, const Key& key, const Box& bounds);
+
+  /**
+     Return an iterator to the item at a handle.
+
+     This climbs from the item's leaf to the root, so it costs about as much
+     as walking down to the item without any searching.  The handle must be
+     current, see ItemHandle.
+  */
+  [[nodiscard]] data_iterator locate(const ItemHandle& handle) noexcept;
+
   /// Erase the given item
   DatEntry erase(data_iterator& i);
 
+  /**
+     Erase the given item without condensing the tree.
+
+     The item is removed from its leaf immediately, so it is no longer found
+     by queries, but under-filled nodes and directory keys that could shrink
+     are only marked for repair by compact().  Erasing this way takes
+     O(height) time, without the latency spikes that reinsertion can cause.
+  */
+  DatEntry erase_deferred(data_iterator& i);
+
+  /**
+     Repair nodes left behind by erase_deferred() within a budget.
+
+     This finds marked leaves, removes under-filled nodes, reinserts their
+     children, and shrinks directory keys, one leaf at a time until either
+     nothing is left to repair or `budget.spend()` returns false.  The budget
+     is spent once for every node visited, but at least one leaf is always
+     repaired, so repeated calls make progress even with a tiny budget.
+
+     @param budget Budget like spaix::budget::Nodes or spaix::budget::Deadline.
+     @return True if the tree is fully compacted.
+  */
+  template<class Budget>
+  bool compact(Budget& budget) noexcept;
+
+  /**
+     Erase every item covered by a search that satisfies a condition.
+
+     This removes all matches in a single traversal, and only then reinserts
+     the remaining children of nodes that became under-filled, so it is much
+     cheaper than erasing many items one at a time.  The tree is only
+     condensed once, and nodes that would be emptied later are never
+     reinserted.
+
+     @param search Search predicate for the items to consider.
+     @param condition Function called with each data node covered by the
+     search, which returns true if it should be erased.
+     @return The number of erased items.
+  */
+  template<class S, class Condition>
+  size_t erase_if(const S& search, const Condition& condition);
+
+  /**
+     Move every item covered by a search into a new tree.
+
+     Subtrees whose keys are covered by the search are detached and moved to
+     the new tree whole, and only the matching items of partially covered
+     leaves are moved individually.  The new tree is built by grafting the
+     detached subtrees beneath each other at their own heights, so moved
+     items are not reinserted one by one, and this tree is condensed once
+     afterwards like with erase_if().
+
+     In addition to the usual `directory()` and `leaf()` methods, the search
+     must have a `covers()` method which returns true only if every key
+     within the given directory key matches.
+
+     @return A tree with the same insertion and split algorithms as this one,
+     and a default-constructed observer.
+  */
+  template<class S>
+  [[nodiscard]] RTree extract(const S& search);
+
+  /**
+     Rebuild the whole tree with as few and as full nodes as possible.
+
+     Items are packed into leaves with Sort-Tile-Recursive: they are sorted
+     into slabs along the first dimension, each slab is sorted into tiles
+     along the next, and so on, then each level of directories is packed the
+     same way.  This removes the overlap and empty space that accumulate
+     after many insertions and erasures, at the cost of visiting every item.
+     Existing nodes are reused, so this only allocates temporary arrays of
+     entries.  Any loose bounds from insert() or relocate() are lost.
+  */
+  void optimize();
+
+  /**
+     Rebuild only the subtrees whose children overlap too much.
+
+     The overlap of a directory is the total volume of the pairwise
+     intersections of its children, divided by its own volume.  Directories
+     are checked from the root down, and the first ones found with an overlap
+     above `max_overlap` have their subtree repacked like optimize(), except
+     with the same number of nodes at each level, so the height and fill of
+     the tree are preserved.  Directories below one that is fine are only
+     checked, so this is cheap enough to run regularly to keep a tree in
+     shape.
+
+     The difference of two coordinates in any dimension must be convertible
+     to `double`.
+
+     @return The number of rebuilt subtrees.
+  */
+  size_t optimize(double max_overlap);
+
+  /**
+     Move all items from another tree into this one.
+
+     Rather than reinserting every item, whole subtrees of the shorter tree
+     are grafted into the taller one, beneath directories at the level above
+     their own, so only their root keys are compared with existing entries.
+     Nodes are moved, never copied, so iterators to items remain valid, but
+     to the merged tree.  The other tree is left empty.  If the trees have
+     observers, then the other observer is notified that every item was
+     erased, and this one that every item was inserted.
+  */
+  void merge(RTree&& other);
+
+  /**
+     Enable or disable recording how often queries visit each directory.
+
+     While recording, visit_matches() and visit_matches_batched() count every
+     visit to a directory node, which adapt() uses to restructure the tree for
+     the actual query workload.  This costs a relaxed atomic increment per
+     visited node, so const queries can still run concurrently.
+  */
+  void record_visits(const bool recording) noexcept { _recording = recording; }
+
+  /**
+     Restructure the tree for the queries recorded since the last call.
+
+     The root is hot if it was visited, and a child of a hot directory is hot
+     if it received at least an even share of its parent's visits.  Hot
+     directories whose children overlap by more than `max_overlap`, measured
+     like optimize(), are re-split: their grandchildren are tiled into the
+     same number of children, so busy areas are searched with fewer node
+     visits.  Children that were never visited are merged into a cold
+     sibling where they fit in one node, so cold areas use fewer and fuller
+     nodes.  Only visited directories are examined, bottom-up, and their
+     counts are reset, so this can be called periodically while recording.
+
+     @return The number of re-split or merged directories.
+  */
+  size_t adapt(double max_overlap);
+
   /**
      Return a range over all items covered by the given search.
 
@@ -143,17 +369,288 @@ public:
   template<class S>
   [[nodiscard]] TreeRange<Searcher<S>> query(S search);
 
+  /**
+     Save the position of an iterator as a cursor.
+
+     The returned cursor can be passed to resume() to continue a query from
+     this position, as long as the tree has not been modified in between.
+     Cursors from end iterators are empty, and resume to an empty range.
+  */
+  template<class Node>
+  [[nodiscard]] Cursor cursor(
+    const EntryIterator<Node, max_height()>& i) const noexcept;
+
+  /**
+     Resume a query from a saved cursor.
+
+     The search should be the same as the one that the cursor was saved from.
+     This only walks down the saved path, so the cost doesn't depend on how
+     many results preceded the cursor.
+
+     @return A range starting at the cursor position, or nothing if the tree
+     has been modified since the cursor was saved.
+  */
+  template<class S>
+  [[nodiscard]] std::optional<TreeRange<ConstSearcher<S>>> resume(
+    const Cursor& cursor,
+    S             search) const;
+
+  /// Resume a query from a saved cursor
+  template<class S>
+  [[nodiscard]] std::optional<TreeRange<Searcher<S>>> resume(
+    const Cursor& cursor,
+    S             search);
+
+#if SPAIX_USE_COROUTINES
+  /**
+     Return a generator that yields the items covered by a search in batches.
+
+     This is a coroutine alternative to query() which yields batches of up to
+     `batch_size` items, so a caller in a coroutine can process a batch,
+     suspend to do something else, then continue with the next.  The
+     iteration state is the same as a query iterator, and is allocated once
+     along with the coroutine frame, so there is no allocation per item.
+
+     @code{.cpp}
+     for (const auto& batch : tree.query_batches<64U>(search)) {
+       for (const DataNode<Key, Data>& node : batch) {
+         // ...
+       }
+       co_await flush();
+     }
+     @endcode
+
+     The tree must not be modified while the generator is in use.
+  */
+  template<unsigned batch_size = 64U, class S>
+  [[nodiscard]] Generator<Batch<batch_size>> query_batches(S search) const;
+#endif
+
   /// Visit every entry in the tree that matches a predicate
   template<class Predicate, class Visitor>
   void visit_matches(const Predicate& predicate,
                      const Visitor&   visitor) const noexcept;
 
-  /// Remove all items from the tree
+  /**
+     Visit entries that match a predicate until a budget is exhausted.
+
+     Subtrees are visited depth-first, with more populous children visited
+     first, until either every match has been visited or `budget.spend()`
+     returns false.  In the latter case, the skipped subtrees are recorded in
+     `progress`, and the query can be resumed by calling this again with the
+     same progress, as long as the tree has not been modified.
+
+     @param predicate Search predicate.
+     @param visitor Function called with every matching data node.
+     @param budget Budget like spaix::budget::Nodes, spent once per node.
+     @param progress Query progress, default-constructed for a new query.
+  */
+  template<class Predicate, class Visitor, class Budget>
+  void visit_matches(const Predicate& predicate,
+                     const Visitor&   visitor,
+                     Budget&          budget,
+                     Progress&        progress) const noexcept;
+
+  /**
+     Visit entries that match a predicate in contiguous batches.
+
+     This is like visit_matches(), but calls the visitor once per leaf with a
+     contiguous BatchView of all the matches in that leaf, so processing can
+     be vectorized and the per-call overhead is amortized.  If data is
+     inlined, and every item in a leaf matches, then the batch refers
+     directly to the leaf's children.  Otherwise, the matches are gathered
+     into a fixed buffer on the stack, as copies of inlined data nodes, or as
+     pointers to separately allocated ones.  The visitor is never called
+     with an empty batch.
+
+     @param predicate Search predicate.
+     @param visitor Function called with a `const BatchView&` of matches.
+  */
+  template<class Predicate, class Visitor>
+  void visit_matches_batched(const Predicate& predicate,
+                             const Visitor&   visitor) const noexcept;
+
+  /**
+     Visit entries that match a predicate with several threads.
+
+     The upper levels of the tree are split into at least a few tasks per
+     thread, one for each matching subtree, which threads take from a shared
+     queue until none remain.  One thread is started for every visitor after
+     the first, and the calling thread also does work with the first visitor.
+     Each visitor is only called by a single thread, so visitors can
+     accumulate state without synchronization, which can be merged after this
+     returns.  The order of visits is unspecified.
+
+     This only reads the tree, so several parallel or regular queries can run
+     at once, but the tree must not be modified until they are finished.
+
+     @param predicate Search predicate.
+     @param visitors Per-thread functions called with matching data nodes.
+  */
+  template<class Predicate, class Visitor>
+  void visit_matches_parallel(const Predicate&      predicate,
+                              std::vector<Visitor>& visitors) const;
+
+  /**
+     Run many independent queries with several threads.
+
+     Queries are first sorted by the path to the first leaf that they may
+     match, so queries that touch the same part of the tree run close
+     together and reuse the same cached nodes.  Threads then take runs of
+     consecutive queries in this order from a shared counter, so the only
+     synchronization is one atomic increment per run.  As with
+     visit_matches_parallel(), one thread is started for every visitor after
+     the first, and each visitor is only called by a single thread.
+
+     @param predicates Search predicates for every query.
+     @param visitors Per-thread functions called with the index of a query in
+     `predicates` and a data node that matches it.
+  */
+  template<class Predicate, class Visitor>
+  void visit_matches_batch(const std::vector<Predicate>& predicates,
+                           std::vector<Visitor>&         visitors) const;
+
+  /**
+     Visit entries that match a predicate in order along a dimension.
+
+     Matches are visited in ascending order of their lower bound in `dim`,
+     using a best-first traversal ordered by the lower bounds of directory
+     keys.  Only the frontier of the search is kept in memory, so the first
+     matches are visited without collecting and sorting every result.
+
+     @param predicate Search predicate.
+     @param visitor Function called with every matching data node, which
+     returns VisitStatus::finish to terminate the search.
+  */
+  template<size_t dim, class Predicate, class Visitor>
+  void visit_matches_sorted(const Predicate& predicate,
+                            const Visitor&   visitor) const;
+
+  /**
+     Visit a sample of the entries that match a predicate.
+
+     This is like visit_matches(), but stops descending into any directory
+     whose key is no larger than `resolution` in every dimension, and visits
+     a single representative entry in it instead.  The number of visited
+     entries is therefore bounded by the number of resolution-sized areas
+     that match, regardless of how dense the data is.  The representative of
+     a directory is the first matching entry found in a depth-first search
+     of it, so no extra data needs to be stored in the tree.
+
+     @param predicate Search predicate.
+     @param resolution Maximum extent in each dimension of a directory that
+     is represented by a single entry.
+     @param visitor Function called with every visited data node.
+  */
+  template<class Predicate, class Resolution, class Visitor>
+  void visit_matches_sampled(const Predicate&  predicate,
+                             const Resolution& resolution,
+                             const Visitor&    visitor) const noexcept;
+
+  /**
+     Return the skyline of the items that match a search.
+
+     The skyline is the set of items that are not dominated by any other,
+     where one item dominates another if its lower corner is less than or
+     equal to the other's in every dimension, and less in at least one.  This
+     uses a branch-and-bound search which visits subtrees in lexicographic
+     order of their lower corners, so items are only reached after everything
+     that could dominate them, and prunes any subtree whose lower corner is
+     dominated by an item that has already been found.
+  */
+  template<class S>
+  [[nodiscard]] std::vector<const DatNode*> skyline(const S& search) const;
+
+  /**
+     Count the items in each cell of a grid over a window.
+
+     The window is divided into `cells_per_dim` equal cells in every
+     dimension, and each item whose lower corner is within the window is
+     counted in the cell that contains its lower corner.  The tree is
+     traversed once, and subtrees whose keys fit entirely within a single
+     cell are counted without examining their items individually.
+
+     The difference of two coordinates in any dimension must be convertible
+     to `double`.
+
+     @return A dense array of counts with `cells_per_dim` raised to the
+     number of dimensions elements, where the cell index in dimension 0
+     varies fastest.
+  */
+  [[nodiscard]] std::vector<size_t> histogram(const Box& window,
+                                              size_t     cells_per_dim) const;
+
+  /**
+     Visit the difference between the matches of two predicates.
+
+     This is useful for incrementally updating the results of a query whose
+     area moves, such as a panning viewport.  Subtrees are skipped entirely if
+     neither predicate matches them, or if both predicates cover them, so the
+     cost is proportional to the size of the difference rather than the size
+     of either result.
+
+     In addition to the usual `directory()` and `leaf()` methods, both
+     predicates must have a `covers()` method which returns true only if every
+     key within the given directory key matches the predicate.
+
+     @param previous Predicate for the previous query.
+     @param next Predicate for the new query.
+     @param visit_entered Function called with every data node that matches
+     `next` but not `previous`.
+     @param visit_left Function called with every data node that matches
+     `previous` but not `next`.
+  */
+  template<class Previous, class Next, class EnteredVisitor, class LeftVisitor>
+  void visit_delta(const Previous&       previous,
+                   const Next&           next,
+                   const EnteredVisitor& visit_entered,
+                   const LeftVisitor&    visit_left) const noexcept;
+
+  /**
+     Visit entries that match a predicate, starting near a previous result.
+
+     This is useful when successive queries are spatially close, for example
+     when a client repeatedly queries around its own position.  Rather than
+     starting at the root, the search climbs from the leaf that contains
+     `finger` to the lowest directory whose key contains `window`, and only
+     searches beneath it, so the comparisons in the levels above are skipped
+     entirely.  Since siblings in an R-tree may overlap, matches in other
+     subtrees are not visited, so this is a local search which is only
+     complete if that directory is the root.
+
+     If `finger` is empty, then the search starts at the root like a normal
+     query.  Otherwise, it must refer to an item in this tree, which has not
+     been modified since `finger` was obtained.
+
+     @param finger Iterator to an item, typically from a previous query.
+     @param window Bounds of everything that `predicate` matches.
+     @param predicate Search predicate.
+     @param visitor Function called with every matching data node, which
+     returns VisitStatus::finish to terminate the search.
+  */
+  template<class FingerNode, class Predicate, class Visitor>
+  void visit_nearby(const EntryIterator<FingerNode, max_height()>& finger,
+                    const Box&                                     window,
+                    const Predicate&                               predicate,
+                    const Visitor& visitor) const noexcept;
+
+  /**
+     Remove all items from the tree.
+
+     Unless the tree has a spaix::NullObserver, the observer is notified that
+     every item has been erased.
+  */
   void clear() noexcept
   {
+    if constexpr (!std::is_same_v<Observer, NullObserver>) {
+      visit_matches(search::Everything{},
+                    [this](const DatNode& node) { _observer.erased(node); });
+    }
+
     _root   = {Box{}, nullptr};
     _height = 0U;
     _size   = 0U;
+    ++_version;
   }
 
   /// Return the number of items in the tree
@@ -162,6 +659,15 @@ public:
   /// Return the current height of the tree
   [[nodiscard]] unsigned height() const noexcept { return _height; }
 
+  /// Return a number which changes whenever the tree is modified
+  [[nodiscard]] uint64_t version() const noexcept { return _version; }
+
+  /// Return the observer which is notified of changes to the tree
+  [[nodiscard]] const Observer& observer() const noexcept { return _observer; }
+
+  /// Return the observer which is notified of changes to the tree
+  [[nodiscard]] Observer& observer() noexcept { return _observer; }
+
   /// Return true iff there are no items in the tree
   [[nodiscard]] bool empty() const noexcept { return !_root.node; }
 
@@ -213,13 +719,62 @@ private:
     DirNode& parent,
     Entry    entry) noexcept;
 
+  /// Remove an item without notifying the observer
+  DatEntry remove(data_iterator& i);
+
   void condense_tree(entry_iterator& i) noexcept;
 
+  /**
+     Merge the under-filled child at `index` into a sibling, or refill it.
+
+     @return True if the child was merged and removed from `parent`.
+  */
+  bool merge_child(DirNode& parent, ChildIndex index) noexcept;
+
+  /// Enlarge the directory keys from `i` up to the root to contain `bounds`
+  void loosen(entry_iterator i, const Box& bounds) noexcept;
+
   template<class Predicate, class Visitor>
   void visit_matches_rec(const DirNode&   node,
                          const Predicate& predicate,
                          const Visitor&   visitor) const noexcept;
 
+  template<class Predicate>
+  NodePath locality(const Predicate& predicate) const noexcept;
+
+  template<class Predicate, class Visitor>
+  void visit_matches_batched_rec(const DirNode&   node,
+                                 const Predicate& predicate,
+                                 const Visitor&   visitor) const noexcept;
+
+  template<class Predicate, class Resolution, class Visitor>
+  void visit_matches_sampled_rec(const DirNode&    node,
+                                 const Box&        key,
+                                 const Predicate&  predicate,
+                                 const Resolution& resolution,
+                                 const Visitor&    visitor) const noexcept;
+
+  template<class Predicate, class Visitor>
+  VisitStatus visit_nearby_rec(const DirNode&   node,
+                               const Predicate& predicate,
+                               const Visitor&   visitor) const noexcept;
+
+  void histogram_rec(const DirNode&       node,
+                     const Box&           key,
+                     const Box&           window,
+                     size_t               cells_per_dim,
+                     std::vector<size_t>& counts) const;
+
+  /// Return the number of items in the subtree rooted at `node`
+  static size_t subtree_size(const DirNode& node) noexcept;
+
+  template<class Previous, class Next, class EnteredVisitor, class LeftVisitor>
+  void visit_delta_rec(const DirNode&        node,
+                       const Previous&       previous,
+                       const Next&           next,
+                       const EnteredVisitor& entered,
+                       const LeftVisitor&    left) const noexcept;
+
   /// Create a new parent seeded with a child
   template<class Entry, class Count, Count count>
   [[nodiscard]] static DirEntry new_parent(
@@ -242,16 +797,90 @@ private:
     Entry                                  entry,
     NodeType                               type) noexcept;
 
+  /// Walk down the path of a cursor, or return an empty iterator on failure
+  template<class DataIter, class Node>
+  [[nodiscard]] static DataIter follow(const Cursor& cursor,
+                                       Node*         root) noexcept;
+
+  /// Notify the observer of the positions of leaf children in a range
+  void placed(DirNode& leaf, ChildIndex first, ChildIndex last) noexcept;
+
   /// Reinsert children from an old directory node
   template<class Entry, class Fanout, Fanout fanout>
   void reinsert_children(
     unsigned                                skip,
     StaticVectorView<Entry, Fanout, fanout> entries) noexcept;
 
+  /// A node that was removed from the tree, and its height above the leaves
+  struct Orphan {
+    unsigned                 level;
+    std::unique_ptr<DirNode> node;
+  };
+
+  template<class S, class Condition>
+  size_t erase_if_rec(DirNode&             node,
+                      unsigned             level,
+                      const S&             search,
+                      const Condition&     condition,
+                      std::vector<Orphan>& orphans);
+
+  template<class S>
+  size_t extract_rec(DirNode&               node,
+                     unsigned               level,
+                     const S&               search,
+                     std::vector<Orphan>&   subtrees,
+                     std::vector<DatEntry>& items,
+                     std::vector<Orphan>&   orphans);
+
+  /// Reinsert removed nodes and replace the root if it became empty
+  void condense_orphans(std::vector<Orphan>& orphans) noexcept;
+
+  /// Reinsert the children of a removed node, splitting it if it's too tall
+  void reinsert_orphan(unsigned level, DirNode& node) noexcept;
+
+  /// Nodes detached from a subtree at each level, to reuse when rebuilding
+  using NodePools = std::vector<std::vector<std::unique_ptr<DirNode>>>;
+
+  /// Move all items and nodes beneath `node` at `level` into arrays
+  static void detach(DirNode&               node,
+                     unsigned               level,
+                     std::vector<DatEntry>& items,
+                     NodePools&             pools);
+
+  /// Tile `entries` into `n_nodes` new parents, reusing nodes from `pool`
+  template<class Entry>
+  std::vector<DirEntry> pack(std::vector<Entry>&                    entries,
+                             size_t                                 n_nodes,
+                             NodeType                               type,
+                             std::vector<std::unique_ptr<DirNode>>& pool,
+                             bool                                   dirty);
+
+  size_t optimize_rec(DirEntry& entry, unsigned level, double max_overlap);
+
+  size_t adapt_rec(DirEntry& entry, bool hot, double max_overlap);
+
+  /// Insert a subtree from another tree with its root at `level`
+  void graft(unsigned level, DirEntry entry) noexcept;
+
+  /// Notify observers that the items beneath `node` moved from `other`
+  void adopt(RTree& other, DirNode& node);
+
+  /// Tile the grandchildren of `node` into the same number of children
+  void resplit(DirNode& node);
+
+  /// Merge the unvisited child at `index` into an unvisited sibling if it fits
+  bool merge_cold(DirNode& parent, ChildIndex index) noexcept;
+
+  /// Move the child at index `c` of `src` to the end of `dst`
+  void move_child(DirNode& src, ChildIndex c, DirNode& dst) noexcept;
+
   size_t    _size{};               ///< Number of elements
   Insertion _insertion{};          ///< Insertion algorithm
   Split     _split{};              ///< Split algorithm
+  Observer  _observer{};           ///< Change observer
+  uint64_t  _version{};            ///< Modification counter
   unsigned  _height{};             ///< Height of tree
+  bool      _recording{};          ///< True if query visits are recorded
   DirEntry  _root{Box{}, nullptr}; ///< Key and pointer to root node
 };
 
@@ -4,19 +4,43 @@
 #ifndef SPAIX_RTREE_IPP
 #define SPAIX_RTREE_IPP
 
+#include <spaix/ReinsertUnderflow.hpp>
 #include <spaix/StaticVectorView.hpp>
 #include <spaix/TreeRange.hpp>
 #include <spaix/detail/DirectoryNode.hpp>
+#include <spaix/detail/Index.hpp>
 #include <spaix/detail/entry.hpp>
+#include <spaix/detail/matches.hpp>
 #include <spaix/types.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <numeric>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace spaix {
+namespace detail {
+
+/// Whether an observer has a `placed()` method for items of type `DatNode`
+template<class Observer, class DatNode, class = void>
+struct ObservesPlacement : std::false_type {};
+
+template<class Observer, class DatNode>
+struct ObservesPlacement<
+  Observer,
+  DatNode,
+  std::void_t<decltype(std::declval<Observer&>().placed(
+    std::declval<const DatNode&>(),
+    std::declval<const ItemHandle&>()))>> : std::true_type {};
+
+} // namespace detail
 
 template<class B, class K, class D, class C>
 RTree<B, K, D, C>::RTree(Insertion insertion, Split split) noexcept
@@ -24,6 +48,15 @@ RTree<B, K, D, C>::RTree(Insertion insertion, Split split) noexcept
   , _split{std::move(split)}
 {}
 
+template<class B, class K, class D, class C>
+RTree<B, K, D, C>::RTree(Insertion insertion,
+                         Split     split,
+                         Observer  observer) noexcept
+  : _insertion{std::move(insertion)}
+  , _split{std::move(split)}
+  , _observer{std::move(observer)}
+{}
+
 template<class B, class K, class D, class C>
 auto
 RTree<B, K, D, C>::insert(const Key& key, const Data& data) -> data_iterator
@@ -35,6 +68,8 @@ RTree<B, K, D, C>::insert(const Key& key, const Data& data) -> data_iterator
 
   auto i = insert_entry(_height - 1U, DirNode::make_dat_entry(key, data));
   ++_size;
+  ++_version;
+  _observer.inserted(*i);
   return i;
 }
 
@@ -44,30 +79,42 @@ RTree<B, K, D, C>::relocate(data_iterator& i, const Key& key)
 {
   assert(!i.empty());
 
+  const Key old_key = i->first;
+
+  ++_version;
   if (i.parent() == _root.node.get()) {
     // Base case: element is a child of the root
     i->first  = key;
     _root.key = ideal_key(*_root.node);
+    _observer.relocated(old_key, *i);
   } else {
     const auto dat_parent = i.parent();
     const auto dat_index  = i.index();
     auto&      dat_entry  = dat_parent->dat_children()[dat_index];
 
+    // Find the lowest directory on the path whose bounds contain the new key
+    const data_iterator item = i;
     i.step_up();
-    auto* e = &i.parent()->dir_children()[i.index()];
-    if (Ops::unify(e->key, key) == e->key) {
-      // Fast path: new key is within existing directory's bounds
+    auto fits = i;
+    for (; !fits.empty(); fits.step_up()) {
+      const auto& e = fits.parent()->dir_children()[fits.index()];
+      if (Ops::unify(e.key, key) == e.key) {
+        break;
+      }
+    }
+
+    if (!fits.empty()) {
+      // Fast path: new key is within an existing directory's bounds
       detail::entry_key(dat_entry) = key;
 
-      // Shrink directory keys upwards as necessary
-      auto new_key    = ideal_key(*e->node);
-      bool condensing = (new_key != e->key);
+      // Update directory keys upwards until they no longer change
+      bool condensing = true;
       for (; !i.empty() && condensing; i.step_up()) {
-        e          = &i.parent()->dir_children()[i.index()];
-        new_key    = ideal_key(*e->node);
-        condensing = (new_key != e->key);
+        auto&      e       = i.parent()->dir_children()[i.index()];
+        const auto new_key = ideal_key(*e.node);
+        condensing         = (new_key != e.key);
         if (condensing) {
-          e->key = new_key;
+          e.key = new_key;
         }
       }
 
@@ -76,14 +123,123 @@ RTree<B, K, D, C>::relocate(data_iterator& i, const Key& key)
         _root.key = ideal_key(*_root.node);
       }
 
+      i = item;
+      _observer.relocated(old_key, detail::entry_ref(dat_entry));
+
     } else {
       // Slow path: erase and reinsert normally
       i.step_down(dat_parent, dat_index); // Restore iterator
 
-      auto entry               = erase(i);
+      auto entry               = remove(i);
       detail::entry_key(entry) = key;
-      insert_entry(_height - 1U, std::move(entry));
+      i                        = insert_entry(_height - 1U, std::move(entry));
       ++_size;
+      _observer.relocated(old_key, *i);
+    }
+  }
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::relocate(const ItemHandle& handle, const Key& key)
+{
+  auto i = locate(handle);
+  relocate(i, key);
+}
+
+template<class B, class K, class D, class C>
+auto
+RTree<B, K, D, C>::insert(const Key& key, const Data& data, const Box& bounds)
+  -> data_iterator
+{
+  assert(Ops::unify(bounds, key) == bounds);
+
+  auto           i    = insert(key, data);
+  entry_iterator leaf = i;
+  leaf.step_up();
+  loosen(leaf, bounds);
+  return i;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::relocate(data_iterator& i,
+                            const Key&     key,
+                            const Box&     bounds)
+{
+  assert(!i.empty());
+  assert(Ops::unify(bounds, key) == bounds);
+
+  entry_iterator leaf = i;
+  leaf.step_up();
+
+  const Box& leaf_key =
+    leaf.empty() ? _root.key
+                 : leaf.parent()->dir_children()[leaf.index()].key;
+
+  if (Ops::unify(leaf_key, key) == leaf_key) {
+    // Fastest path: the leaf's loose key still contains the item
+    const Key old_key = i->first;
+
+    ++_version;
+    i->first = key;
+    _observer.relocated(old_key, *i);
+  } else {
+    // Move the item normally, then give its new leaf some room
+    relocate(i, key);
+
+    leaf = i;
+    leaf.step_up();
+    loosen(leaf, bounds);
+  }
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::relocate(const ItemHandle& handle,
+                            const Key&        key,
+                            const Box&        bounds)
+{
+  auto i = locate(handle);
+  relocate(i, key, bounds);
+}
+
+template<class B, class K, class D, class C>
+auto
+RTree<B, K, D, C>::locate(const ItemHandle& handle) noexcept -> data_iterator
+{
+  auto* node = static_cast<DirNode*>(handle.leaf);
+  assert(node);
+  assert(handle.index < node->num_children());
+
+  data_iterator i;
+  i.step_down(node, static_cast<ChildIndex>(handle.index));
+  for (auto* parent = node->parent(); parent; parent = node->parent()) {
+    const auto children = parent->dir_children();
+    ChildIndex index    = 0U;
+    while (children[index].node.get() != node) {
+      assert(index + 1U < children.size());
+      ++index;
+    }
+
+    i.push_front(parent, index);
+    node = parent;
+  }
+
+  assert(node == _root.node.get());
+  return i;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::placed(DirNode&         leaf,
+                          const ChildIndex first,
+                          const ChildIndex last) noexcept
+{
+  if constexpr (detail::ObservesPlacement<Observer, DatNode>::value) {
+    auto children = leaf.dat_children();
+    for (auto i = first; i < last; ++i) {
+      _observer.placed(detail::entry_ref(children[i]), ItemHandle{&leaf, i});
     }
   }
 }
@@ -99,7 +255,9 @@ RTree<B, K, D, C>::insert_entry(const unsigned depth, Entry entry) noexcept
   };
 
   data_iterator iter;
-  const auto    entry_key = detail::entry_key(entry);
+  const auto    entry_key     = detail::entry_key(entry);
+  const auto    entry_summary = DirNode::entry_summary(entry);
+  const auto    entry_dirty   = DirNode::entry_dirty(entry);
 
   // Walk down, choosing directories
   std::array<std::pair<Box, ChildIndex>, max_height()> choices;
@@ -107,6 +265,11 @@ RTree<B, K, D, C>::insert_entry(const unsigned depth, Entry entry) noexcept
   for (unsigned d = 0U; d < depth; ++d) {
     auto children = down_parent->dir_children();
 
+    down_parent->add_summary(entry_summary);
+    if (entry_dirty) {
+      down_parent->set_dirty(true);
+    }
+
     choices[d] = _insertion.choose(children, entry_key);
     iter.step_down(down_parent, choices[d].second);
     down_parent = children[choices[d].second].node.get();
@@ -115,6 +278,15 @@ RTree<B, K, D, C>::insert_entry(const unsigned depth, Entry entry) noexcept
   // Insert element into leaf
   DirNode* const leaf  = iter.empty() ? _root.node.get() : down_parent;
   auto           parts = insert_leaf(*leaf, std::move(entry));
+  if constexpr (std::is_same_v<Entry, DatEntry>) {
+    if (did_split(parts)) {
+      placed(*parts.sides[0].node, 0U, parts.sides[0].node->num_children());
+      placed(*parts.sides[1].node, 0U, parts.sides[1].node->num_children());
+    } else {
+      placed(*leaf, parts.tracked_index, leaf->num_children());
+    }
+  }
+
   if (did_split(parts)) {
     iter.step_down((parts.tracked_side == Side::left)
                      ? parts.sides[0].node.get()
@@ -127,12 +299,27 @@ RTree<B, K, D, C>::insert_entry(const unsigned depth, Entry entry) noexcept
   // Walk up, handling split children as necessary
   unsigned d = depth;
   for (; d && did_split(parts); --d) {
-    auto& parent                   = *iter.parent_at(d - 1);
-    auto  children                 = parent.dir_children();
+    auto&          parent          = *iter.parent_at(d - 1);
+    auto           children        = parent.dir_children();
+    DirNode* const tracked         = iter.parent_at(d);
     children[iter.index_at(d - 1)] = std::move(parts.sides[0]);
+    children[iter.index_at(d - 1)].node->set_parent(&parent);
     if (children.size() == Conf::dir_fanout) { // Parent full, continue split
       parts = split_node(parent, std::move(parts.sides[1]));
       if (did_split(parts)) {
+        // Track the side that the child with the new entry ended up in
+        for (const auto side : {Side::left, Side::right}) {
+          const auto& side_node =
+            *parts.sides[side == Side::left ? 0U : 1U].node;
+          const auto side_children = side_node.dir_children();
+          for (ChildIndex c = 0U; c < side_children.size(); ++c) {
+            if (side_children[c].node.get() == tracked) {
+              parts.tracked_side  = side;
+              parts.tracked_index = c;
+            }
+          }
+        }
+
         iter.set_frame(d - 1,
                        (parts.tracked_side == Side::left)
                          ? parts.sides[0].node.get()
@@ -140,6 +327,10 @@ RTree<B, K, D, C>::insert_entry(const unsigned depth, Entry entry) noexcept
                        parts.tracked_index);
       }
     } else { // Append split RHS
+      if (tracked == parts.sides[1].node.get()) {
+        iter.set_frame(d - 1, &parent, children.size());
+      }
+
       parent.append_child(std::move(parts.sides[1]));
       parts.sides = {};
     }
@@ -169,183 +360,1984 @@ RTree<B, K, D, C>::insert_entry(const unsigned depth, Entry entry) noexcept
 template<class B, class K, class D, class C>
 auto
 RTree<B, K, D, C>::erase(data_iterator& i) -> DatEntry
+{
+  auto entry = remove(i);
+  ++_version;
+  _observer.erased(detail::entry_ref(entry));
+  return entry;
+}
+
+template<class B, class K, class D, class C>
+auto
+RTree<B, K, D, C>::erase_deferred(data_iterator& i) -> DatEntry
 {
   assert(!i.empty());
 
   // Drop leaf entry
-  auto entry = std::move(i.parent()->dat_children()[i.index()]);
-  i.parent()->dat_children().pop_at(i.index());
-  i.step_up();
+  auto* const leaf  = i.parent();
+  auto        entry = std::move(leaf->dat_children()[i.index()]);
+  leaf->dat_children().pop_at(i.index());
+  if (i.index() < leaf->num_children()) {
+    const auto gap = i.index(); // Last child moved here
+    placed(*leaf, gap, static_cast<ChildIndex>(gap + 1U));
+  }
+
+  ++_version;
   if (--_size == 0U) {
     clear();
-    return entry;
+  } else {
+    // Mark the path to the leaf for compaction (stopping at a marked node)
+    for (auto* node = leaf; node && !node->dirty(); node = node->parent()) {
+      node->set_dirty(true);
+    }
   }
 
-  // Condense tree by re-inserting any under-full directory nodes
-  condense_tree(i);
-
-  assert(!(_root.node->child_type() == NodeType::directory &&
-           _root.node->num_children() == 1));
-
+  _observer.erased(detail::entry_ref(entry));
   return entry;
 }
 
 template<class B, class K, class D, class C>
-template<class S>
-auto
-RTree<B, K, D, C>::query(S search) const -> TreeRange<ConstSearcher<S>>
+template<class Budget>
+bool
+RTree<B, K, D, C>::compact(Budget& budget) noexcept
 {
-  if (empty()) {
-    return {{{Box{}, nullptr}, search}, {{Box{}, nullptr}, search}};
-  }
+  bool exhausted = false;
+  while (_root.node && _root.node->dirty()) {
+    if (exhausted) {
+      return false;
+    }
 
-  ConstSearcher<S> first{_root, search};
-  ConstSearcher<S> last{{Box{}, nullptr}, search};
+    // Walk down to the first marked leaf, unmarking any exhausted directory
+    entry_iterator i;
+    DirNode*       node = _root.node.get();
+    while (node && node->child_type() == NodeType::directory) {
+      exhausted = !budget.spend() || exhausted;
 
-  assert(first == last || search.leaf(first->first));
+      const auto children = node->dir_children();
+      ChildIndex c        = 0U;
+      while (c < children.size() && !children[c].node->dirty()) {
+        ++c;
+      }
 
-  return {std::move(first), std::move(last)};
+      if (c == children.size()) {
+        node->set_dirty(false);
+        node = nullptr;
+      } else {
+        i.step_down(node, c);
+        node = children[c].node.get();
+      }
+    }
+
+    if (node) {
+      // Remove the leaf if it is under-filled, and shrink keys upwards
+      exhausted = !budget.spend() || exhausted;
+      node->set_dirty(false);
+      condense_tree(i);
+    }
+  }
+
+  return true;
 }
 
 template<class B, class K, class D, class C>
-template<class S>
-auto
-RTree<B, K, D, C>::query(S search) -> TreeRange<Searcher<S>>
+template<class S, class Condition>
+size_t
+RTree<B, K, D, C>::erase_if(const S& search, const Condition& condition)
 {
-  if (empty()) {
-    return {{{Box{}, nullptr}, search}, {{Box{}, nullptr}, search}};
+  if (!_root.node || !detail::dir_matches(search, _root)) {
+    return 0U;
   }
 
-  Searcher<S> first{_root, search};
-  Searcher<S> last{{Box{}, nullptr}, search};
+  // Remove all matches, collecting under-filled nodes along the way
+  std::vector<Orphan> orphans;
+  const auto          n_erased =
+    erase_if_rec(*_root.node, _height - 1U, search, condition, orphans);
+  if (!n_erased) {
+    return 0U;
+  }
 
-  assert(first == last || search.leaf(first->first));
+  ++_version;
+  if (!(_size -= n_erased)) {
+    clear();
+    return n_erased;
+  }
 
-  return {std::move(first), std::move(last)};
+  condense_orphans(orphans);
+  return n_erased;
 }
 
 template<class B, class K, class D, class C>
-template<class Children>
-auto
-RTree<B, K, D, C>::parent_key(const Children& children) noexcept -> Box
+void
+RTree<B, K, D, C>::condense_orphans(std::vector<Orphan>& orphans) noexcept
 {
-  return std::accumulate(children.begin(),
-                         children.end(),
-                         Box{},
-                         [](const Box& box, const auto& entry) {
-                           return Ops::unify(box, detail::entry_key(entry));
-                         });
-}
+  if (_root.node->num_children()) {
+    _root.key = ideal_key(*_root.node);
+  } else {
+    // Every child of the root was removed, use the tallest orphan instead
+    const auto tallest = std::max_element(
+      orphans.begin(), orphans.end(), [](const auto& l, const auto& r) {
+        return std::make_pair(!!l.node->num_children(), l.level) <
+               std::make_pair(!!r.node->num_children(), r.level);
+      });
+
+    _height = tallest->level + 1U;
+    _root   = {ideal_key(*tallest->node), std::move(tallest->node)};
+    _root.node->set_parent(nullptr);
+  }
 
-template<class B, class K, class D, class C>
-auto
-RTree<B, K, D, C>::ideal_key(const DirNode& node) noexcept -> Box
-{
-  if (node.child_type() == NodeType::directory) {
-    return parent_key(node.dir_children());
+  // Reinsert orphans, shortest first so the tree is tall enough for the rest
+  std::sort(orphans.begin(), orphans.end(), [](const auto& l, const auto& r) {
+    return l.level < r.level;
+  });
+
+  for (auto& orphan : orphans) {
+    if (orphan.node) {
+      reinsert_orphan(orphan.level, *orphan.node);
+    }
   }
 
-  return parent_key(node.dat_children());
+  // Remove superfluous roots
+  while (_root.node->child_type() == NodeType::directory &&
+         _root.node->num_children() == 1) {
+    _root = std::move(_root.node->dir_children()[0]);
+    _root.node->set_parent(nullptr);
+    --_height;
+  }
 }
 
 template<class B, class K, class D, class C>
-template<class Entry>
-auto
-RTree<B, K, D, C>::insert_leaf(DirNode& parent, Entry entry) noexcept
-  -> SplitParts<DirEntry, ChildIndex>
+template<class S, class Condition>
+size_t
+RTree<B, K, D, C>::erase_if_rec(DirNode&             node,
+                                const unsigned       level,
+                                const S&             search,
+                                const Condition&     condition,
+                                std::vector<Orphan>& orphans)
 {
-  if (parent.num_children() >= Conf::fanout(parent.child_type())) {
-    // Split insert
-    return split_node(parent, std::move(entry));
+  size_t n_erased = 0U;
+  if (node.child_type() == NodeType::data) {
+    auto children = node.dat_children();
+    for (ChildIndex i = 0U; i < children.size();) {
+      const auto& entry = children[i];
+      if (detail::dat_matches<DirNode>(search, entry) &&
+          condition(detail::entry_ref(entry))) {
+        _observer.erased(detail::entry_ref(entry));
+        children.pop_at(i);
+        ++n_erased;
+        if (i < children.size()) {
+          placed(node, i, static_cast<ChildIndex>(i + 1U)); // Moved here
+        }
+      } else {
+        ++i;
+      }
+    }
+  } else {
+    auto children = node.dir_children();
+    for (ChildIndex i = 0U; i < children.size();) {
+      auto& entry = children[i];
+      if (detail::dir_matches(search, entry)) {
+        const auto n = erase_if_rec(
+          *entry.node, level - 1U, search, condition, orphans);
+
+        n_erased += n;
+        if (n && entry.node->num_children() <
+                   Conf::min_fanout(entry.node->child_type())) {
+          // Child is under-filled, remove it to reinsert its children later
+          orphans.push_back({level - 1U, std::move(entry.node)});
+          children.pop_at(i);
+          continue;
+        }
+
+        if (n) {
+          entry.key = ideal_key(*entry.node);
+        }
+      }
+
+      ++i;
+    }
   }
 
-  // Simple insert
-  SplitParts<DirEntry, ChildIndex> parts{};
-  parts.tracked_index = parent.num_children();
-  parent.append_child(std::move(entry));
-  return parts;
+  if (n_erased) {
+    node.update_summary();
+  }
+
+  return n_erased;
 }
 
 template<class B, class K, class D, class C>
-void
-RTree<B, K, D, C>::condense_tree(entry_iterator& i) noexcept
+template<class S>
+auto
+RTree<B, K, D, C>::extract(const S& search) -> RTree
 {
-  // Condense upwards by removing under-filled directory nodes
-  StaticVector<std::unique_ptr<DirNode>, unsigned, max_height()> removed;
-  bool condensing = true;
-  for (; !i.empty() && condensing; i.step_up()) {
-    auto& e = i.parent()->dir_children()[i.index()];
-    if (e.node->num_children() < Conf::min_fanout(e.node->child_type())) {
-      // This entry's node is under-filled, remove it and continue
-      removed.emplace_back(std::move(e.node));
-      i.parent()->dir_children().pop_at(i.index());
-    } else {
-      // Recompute this entry's key and continue if it shrank
-      const auto new_key = ideal_key(*e.node);
-      condensing         = (new_key != e.key);
-      if (condensing) {
-        e.key = new_key;
-      }
-    }
+  RTree result{_insertion, _split};
+  if (!_root.node || !detail::dir_matches(search, _root)) {
+    return result;
   }
 
-  // Shrink the root key if necessary
-  if (condensing) {
-    assert(i.empty() || i.parent() == _root.node.get());
-    _root.key = ideal_key(*_root.node);
+  if (detail::dir_covers(search, _root)) {
+    result.merge(std::move(*this));
+    return result;
   }
-  assert(_root.key == ideal_key(*_root.node));
 
-  // Reinsert the children of all the removed directories
-  for (auto h = 0U; h < removed.size(); ++h) {
-    if (removed[h]->child_type() == NodeType::directory) {
-      reinsert_children(h, removed[h]->dir_children());
+  // Detach covered subtrees and matching items, and collect under-filled nodes
+  std::vector<Orphan>   subtrees;
+  std::vector<DatEntry> items;
+  std::vector<Orphan>   orphans;
+  const auto            n_extracted = extract_rec(
+    *_root.node, _height - 1U, search, subtrees, items, orphans);
+  if (!n_extracted) {
+    return result;
+  }
+
+  // Graft subtrees into the result from the tallest down
+  std::sort(subtrees.begin(), subtrees.end(), [](const auto& l, const auto& r) {
+    return r.level < l.level;
+  });
+
+  for (auto& subtree : subtrees) {
+    if constexpr (!std::is_same_v<Observer, NullObserver>) {
+      result.adopt(*this, *subtree.node);
+    }
+
+    DirEntry entry{ideal_key(*subtree.node), std::move(subtree.node)};
+    if (result.empty()) {
+      result._height = subtree.level + 1U;
+      result._root   = std::move(entry);
+      result._root.node->set_parent(nullptr);
     } else {
-      reinsert_children(h, removed[h]->dat_children());
+      result.graft(subtree.level, std::move(entry));
     }
   }
 
-  // Remove superfluous root if possible
-  if (_root.node->child_type() == NodeType::directory &&
-      _root.node->num_children() == 1) {
-    _root = std::move(_root.node->dir_children()[0]);
-    --_height;
+  // Insert items from partially covered leaves
+  for (auto& item : items) {
+    if (result.empty()) {
+      result._root   = {B{detail::entry_key(item)},
+                        std::make_unique<DirNode>(NodeType::data)};
+      result._height = 1U;
+    }
+
+    const auto i = result.insert_entry(result._height - 1U, std::move(item));
+    result._observer.inserted(*i);
+  }
+
+  result._size = n_extracted;
+  ++result._version;
+
+  // Condense this tree once
+  ++_version;
+  if (!(_size -= n_extracted)) {
+    clear();
+  } else {
+    condense_orphans(orphans);
   }
+
+  return result;
 }
 
 template<class B, class K, class D, class C>
-template<class Predicate, class Visitor>
-void
-RTree<B, K, D, C>::visit_matches(const Predicate& predicate,
-                                 const Visitor&   visitor) const noexcept
+template<class S>
+size_t
+RTree<B, K, D, C>::extract_rec(DirNode&               node,
+                               const unsigned         level,
+                               const S&               search,
+                               std::vector<Orphan>&   subtrees,
+                               std::vector<DatEntry>& items,
+                               std::vector<Orphan>&   orphans)
 {
-  if (_root.node && predicate.directory(_root.key)) {
-    visit_matches_rec(*_root.node, predicate, visitor);
+  size_t n_extracted = 0U;
+  if (node.child_type() == NodeType::data) {
+    auto children = node.dat_children();
+    for (ChildIndex i = 0U; i < children.size();) {
+      if (detail::dat_matches<DirNode>(search, children[i])) {
+        _observer.erased(detail::entry_ref(children[i]));
+        items.emplace_back(std::move(children[i]));
+        children.pop_at(i);
+        ++n_extracted;
+        if (i < children.size()) {
+          placed(node, i, static_cast<ChildIndex>(i + 1U)); // Moved here
+        }
+      } else {
+        ++i;
+      }
+    }
+  } else {
+    auto children = node.dir_children();
+    for (ChildIndex i = 0U; i < children.size();) {
+      auto& entry = children[i];
+      if (detail::dir_covers(search, entry)) {
+        // Child is covered, detach it to move it to the result whole
+        n_extracted += subtree_size(*entry.node);
+        subtrees.push_back({level - 1U, std::move(entry.node)});
+        children.pop_at(i);
+        continue;
+      }
+
+      if (detail::dir_matches(search, entry)) {
+        const auto n = extract_rec(
+          *entry.node, level - 1U, search, subtrees, items, orphans);
+
+        n_extracted += n;
+        if (n && entry.node->num_children() <
+                   Conf::min_fanout(entry.node->child_type())) {
+          // Child is under-filled, remove it to reinsert its children later
+          orphans.push_back({level - 1U, std::move(entry.node)});
+          children.pop_at(i);
+          continue;
+        }
+
+        if (n) {
+          entry.key = ideal_key(*entry.node);
+        }
+      }
+
+      ++i;
+    }
+  }
+
+  if (n_extracted) {
+    node.update_summary();
   }
+
+  return n_extracted;
 }
 
 template<class B, class K, class D, class C>
-template<class Predicate, class Visitor>
 void
-RTree<B, K, D, C>::visit_matches_rec(const DirNode&   node,
-                                     const Predicate& predicate,
-                                     const Visitor&   visitor) const noexcept
+RTree<B, K, D, C>::reinsert_orphan(const unsigned level,
+                                   DirNode&       node) noexcept
 {
-  if (node.child_type() == NodeType::directory) {
-    for (const auto& entry : node.dir_children()) {
-      if (predicate.directory(entry.key)) {
-        visit_matches_rec(*entry.node, predicate, visitor);
-      }
-    }
+  if (node.child_type() == NodeType::data) {
+    reinsert_children(0U, node.dat_children());
+  } else if (level < _height) {
+    reinsert_children(level, node.dir_children());
   } else {
-    for (const auto& entry : node.dat_children()) {
-      if (predicate.leaf(detail::entry_key(entry))) {
-        visitor(detail::entry_ref(entry));
-      }
+    for (auto& entry : node.dir_children()) {
+      reinsert_orphan(level - 1U, *entry.node);
     }
   }
 }
 
+namespace detail {
+
+template<class Ops, class Iter, size_t n_dims>
+void
+tile_rec(Iter, size_t, size_t, size_t, size_t, EndIndex<n_dims>) noexcept
+{}
+
+/**
+   Sort entries so that nodes `begin` to `end` in order form spatial tiles.
+
+   Node `n` of `n_nodes` gets the entries starting at `n * n_entries /
+   n_nodes`, so runs of nodes and their entries can be sorted independently.
+*/
+template<class Ops, class Iter, size_t dim, size_t n_dims>
+void
+tile_rec(const Iter               first,
+         const size_t             n_entries,
+         const size_t             n_nodes,
+         const size_t             begin,
+         const size_t             end,
+         const Index<dim, n_dims> index) noexcept
+{
+  const auto center = [](const auto& entry) {
+    const auto& key = entry_key(entry);
+    return Ops::template lower<dim>(key) + Ops::template upper<dim>(key);
+  };
+
+  std::sort(first + static_cast<ptrdiff_t>(begin * n_entries / n_nodes),
+            first + static_cast<ptrdiff_t>(end * n_entries / n_nodes),
+            [center](const auto& lhs, const auto& rhs) {
+              return center(lhs) < center(rhs);
+            });
+
+  // Split into slabs so the remaining dimensions get equal numbers of tiles
+  const auto count   = end - begin;
+  size_t     n_slabs = 1U;
+  while (power<size_t>(n_slabs, n_dims - dim) < count) {
+    ++n_slabs;
+  }
+
+  for (size_t s = 0U; s < n_slabs; ++s) {
+    tile_rec<Ops>(first,
+                  n_entries,
+                  n_nodes,
+                  begin + (s * count / n_slabs),
+                  begin + ((s + 1U) * count / n_slabs),
+                  ++index);
+  }
+}
+
+template<class Ops, class Lhs, class Rhs, size_t n_dims>
+constexpr double
+intersection_rec(const Lhs&, const Rhs&, EndIndex<n_dims>) noexcept
+{
+  return 1.0;
+}
+
+/// Return the volume of the intersection of `lhs` and `rhs` as a double
+template<class Ops, class Lhs, class Rhs, size_t dim, size_t n_dims>
+constexpr double
+intersection_rec(const Lhs&               lhs,
+                 const Rhs&               rhs,
+                 const Index<dim, n_dims> index) noexcept
+{
+  const auto lower =
+    std::max(Ops::template lower<dim>(lhs), Ops::template lower<dim>(rhs));
+  const auto upper =
+    std::min(Ops::template upper<dim>(lhs), Ops::template upper<dim>(rhs));
+
+  return (lower < upper) ? static_cast<double>(upper - lower) *
+                             intersection_rec<Ops>(lhs, rhs, ++index)
+                         : 0.0;
+}
+
+/// Return the pairwise overlap of `children` relative to the volume of `key`
+template<class Ops, class Children, class Key>
+double
+overlap(const Children& children, const Key& key) noexcept
+{
+  using Begin = Index<0U, Key::size()>;
+
+  const auto volume = intersection_rec<Ops>(key, key, Begin{});
+  if (volume <= 0.0) {
+    return 0.0;
+  }
+
+  double total = 0.0;
+  for (auto l = children.begin(); l != children.end(); ++l) {
+    for (auto r = std::next(l); r != children.end(); ++r) {
+      total += intersection_rec<Ops>(l->key, r->key, Begin{});
+    }
+  }
+
+  return total / volume;
+}
+
+} // namespace detail
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::optimize()
+{
+  if (!_root.node) {
+    return;
+  }
+
+  std::vector<DatEntry> items;
+  NodePools             pools(_height);
+  items.reserve(_size);
+  detach(*_root.node, _height - 1U, items, pools);
+  pools[_height - 1U].emplace_back(std::move(_root.node));
+
+  // Pack items into full leaves, then each level into full parents
+  auto level = pack(items,
+                    (items.size() + Conf::dat_fanout - 1U) / Conf::dat_fanout,
+                    NodeType::data,
+                    pools[0U],
+                    false);
+
+  _height = 1U;
+  while (level.size() > 1U) {
+    assert(_height < pools.size());
+    level = pack(level,
+                 (level.size() + Conf::dir_fanout - 1U) / Conf::dir_fanout,
+                 NodeType::directory,
+                 pools[_height++],
+                 false);
+  }
+
+  _root = std::move(level.front());
+  _root.node->set_parent(nullptr);
+  ++_version;
+}
+
+template<class B, class K, class D, class C>
+size_t
+RTree<B, K, D, C>::optimize(const double max_overlap)
+{
+  if (!_root.node) {
+    return 0U;
+  }
+
+  const auto n_rebuilt = optimize_rec(_root, _height - 1U, max_overlap);
+  if (n_rebuilt) {
+    ++_version;
+  }
+
+  return n_rebuilt;
+}
+
+template<class B, class K, class D, class C>
+size_t
+RTree<B, K, D, C>::optimize_rec(DirEntry&      entry,
+                                const unsigned level,
+                                const double   max_overlap)
+{
+  auto& node = *entry.node;
+  if (node.child_type() == NodeType::data) {
+    return 0U;
+  }
+
+  if (detail::overlap<Ops>(node.dir_children(), entry.key) <= max_overlap) {
+    size_t n_rebuilt = 0U;
+    for (auto& child : node.dir_children()) {
+      n_rebuilt += optimize_rec(child, level - 1U, max_overlap);
+    }
+
+    return n_rebuilt;
+  }
+
+  // Repack the subtree with the same number of nodes at every level
+  const auto            dirty = node.dirty();
+  std::vector<DatEntry> items;
+  NodePools             pools(level);
+  detach(node, level, items, pools);
+
+  auto children =
+    pack(items, pools[0U].size(), NodeType::data, pools[0U], dirty);
+
+  for (unsigned l = 1U; l < level; ++l) {
+    children = pack(
+      children, pools[l].size(), NodeType::directory, pools[l], dirty);
+  }
+
+  for (auto& child : children) {
+    node.append_child(std::move(child));
+  }
+
+  return 1U;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::detach(DirNode&               node,
+                          const unsigned         level,
+                          std::vector<DatEntry>& items,
+                          NodePools&             pools)
+{
+  if (node.child_type() == NodeType::data) {
+    for (auto& entry : node.dat_children()) {
+      items.emplace_back(std::move(entry));
+    }
+
+    node.dat_children().clear();
+  } else {
+    for (auto& entry : node.dir_children()) {
+      detach(*entry.node, level - 1U, items, pools);
+      pools[level - 1U].emplace_back(std::move(entry.node));
+    }
+
+    node.dir_children().clear();
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Entry>
+auto
+RTree<B, K, D, C>::pack(std::vector<Entry>&                    entries,
+                        const size_t                           n_nodes,
+                        const NodeType                         type,
+                        std::vector<std::unique_ptr<DirNode>>& pool,
+                        const bool                             dirty)
+  -> std::vector<DirEntry>
+{
+  using Begin = detail::Index<0U, Box::size()>;
+
+  detail::tile_rec<Ops>(
+    entries.begin(), entries.size(), n_nodes, 0U, n_nodes, Begin{});
+
+  std::vector<DirEntry> parents;
+  parents.reserve(n_nodes);
+  for (size_t n = 0U; n < n_nodes; ++n) {
+    std::unique_ptr<DirNode> node;
+    if (pool.empty()) {
+      node = std::make_unique<DirNode>(type);
+    } else {
+      node = std::move(pool.back());
+      pool.pop_back();
+    }
+
+    const auto first = n * entries.size() / n_nodes;
+    const auto last  = (n + 1U) * entries.size() / n_nodes;
+    for (auto i = first; i < last; ++i) {
+      node->append_child(std::move(entries[i]));
+    }
+
+    node->update_summary();
+    node->set_dirty(dirty);
+    node->reset_visits();
+    if constexpr (std::is_same_v<Entry, DatEntry>) {
+      placed(*node, 0U, node->num_children());
+    }
+
+    parents.push_back({ideal_key(*node), std::move(node)});
+  }
+
+  return parents;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::merge(RTree&& other)
+{
+  if (other.empty()) {
+    return;
+  }
+
+  if constexpr (!std::is_same_v<Observer, NullObserver>) {
+    adopt(other, *other._root.node);
+  }
+
+  // Graft the shorter tree into the taller one
+  const auto size = _size + other._size;
+  if (empty()) {
+    std::swap(_root, other._root);
+    std::swap(_height, other._height);
+  } else {
+    if (other._height > _height) {
+      std::swap(_root, other._root);
+      std::swap(_height, other._height);
+    }
+
+    graft(other._height - 1U, std::move(other._root));
+  }
+
+  _size = size;
+  ++_version;
+
+  other._root   = {Box{}, nullptr};
+  other._height = 0U;
+  other._size   = 0U;
+  ++other._version;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::graft(const unsigned level, DirEntry entry) noexcept
+{
+  auto& node = *entry.node;
+  if (level + 1U < _height &&
+      node.num_children() >= Conf::min_fanout(node.child_type())) {
+    // Insert the whole subtree beneath a directory at the level above
+    insert_entry(_height - 2U - level, std::move(entry));
+  } else if (node.child_type() == NodeType::data) {
+    // Insert items from a leaf that is too small, or a root leaf
+    reinsert_children(0U, node.dat_children());
+  } else {
+    // Graft children of a directory that is too small or too tall
+    for (auto& child : node.dir_children()) {
+      graft(level - 1U, std::move(child));
+    }
+  }
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::adopt(RTree& other, DirNode& node)
+{
+  if (node.child_type() == NodeType::directory) {
+    for (auto& child : node.dir_children()) {
+      adopt(other, *child.node);
+    }
+  } else {
+    for (const auto& child : node.dat_children()) {
+      other._observer.erased(detail::entry_ref(child));
+      _observer.inserted(detail::entry_ref(child));
+    }
+
+    placed(node, 0U, node.num_children());
+  }
+}
+
+template<class B, class K, class D, class C>
+size_t
+RTree<B, K, D, C>::adapt(const double max_overlap)
+{
+  if (!_root.node || !_root.node->visits()) {
+    return 0U;
+  }
+
+  const auto n_changed = adapt_rec(_root, true, max_overlap);
+  if (n_changed) {
+    ++_version;
+  }
+
+  return n_changed;
+}
+
+template<class B, class K, class D, class C>
+size_t
+RTree<B, K, D, C>::adapt_rec(DirEntry&    entry,
+                             const bool   hot,
+                             const double max_overlap)
+{
+  auto&      node   = *entry.node;
+  const auto visits = size_t{node.visits()};
+  node.reset_visits();
+  if (node.child_type() == NodeType::data) {
+    return 0U;
+  }
+
+  // Merge cold children together while enough children remain
+  size_t n_changed = 0U;
+  auto   children  = node.dir_children();
+  for (ChildIndex c = 0U;
+       c < children.size() && children.size() > Conf::min_dir_fanout;) {
+    if (!children[c].node->visits() && merge_cold(node, c)) {
+      ++n_changed; // Another child was moved to index c
+    } else {
+      ++c;
+    }
+  }
+
+  // Adapt visited children first, which never changes their keys
+  for (auto& child : children) {
+    const auto child_visits = size_t{child.node->visits()};
+    if (child_visits) {
+      const auto child_hot = hot && child_visits * children.size() >= visits;
+      n_changed += adapt_rec(child, child_hot, max_overlap);
+    }
+  }
+
+  // Re-split this node if its children overlap so queries visit several
+  if (hot && children.size() > 1U &&
+      detail::overlap<Ops>(children, entry.key) > max_overlap) {
+    resplit(node);
+    ++n_changed;
+  }
+
+  return n_changed;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::resplit(DirNode& node)
+{
+  std::vector<std::unique_ptr<DirNode>> pool;
+  for (auto& child : node.dir_children()) {
+    pool.emplace_back(std::move(child.node));
+  }
+  node.dir_children().clear();
+
+  // Move all grandchildren out, then tile them into the old children
+  const auto n_nodes = pool.size();
+  const auto type    = pool.front()->child_type();
+  const auto regroup = [&](auto entries, const auto& children_of) {
+    for (auto& child : pool) {
+      auto grandchildren = children_of(*child);
+      for (auto& grandchild : grandchildren) {
+        entries.emplace_back(std::move(grandchild));
+      }
+      grandchildren.clear();
+    }
+
+    for (auto& parent : pack(entries, n_nodes, type, pool, node.dirty())) {
+      node.append_child(std::move(parent));
+    }
+  };
+
+  if (type == NodeType::data) {
+    regroup(std::vector<DatEntry>{},
+            [](DirNode& child) { return child.dat_children(); });
+  } else {
+    regroup(std::vector<DirEntry>{},
+            [](DirNode& child) { return child.dir_children(); });
+  }
+}
+
+template<class B, class K, class D, class C>
+bool
+RTree<B, K, D, C>::merge_cold(DirNode& parent, const ChildIndex index) noexcept
+{
+  using Volume = typename Ops::Volume;
+
+  auto        siblings = parent.dir_children();
+  const auto& child    = siblings[index];
+  const auto  fanout   = Conf::fanout(child.node->child_type());
+
+  // Find the unvisited sibling with enough room that grows the least
+  ChildIndex best        = index;
+  Volume     best_volume = {};
+  for (ChildIndex i = 0U; i < siblings.size(); ++i) {
+    const auto& sibling = siblings[i];
+    if (i != index && !sibling.node->visits() &&
+        child.node->num_children() + sibling.node->num_children() <= fanout) {
+      const auto volume = Ops::volume(Ops::unify(sibling.key, child.key));
+      if (best == index || volume < best_volume) {
+        best        = i;
+        best_volume = volume;
+      }
+    }
+  }
+
+  if (best == index) {
+    return false;
+  }
+
+  // Move everything into the sibling and drop the child
+  auto& sibling = siblings[best];
+  auto& from    = *child.node;
+  while (from.num_children()) {
+    move_child(
+      from, static_cast<ChildIndex>(from.num_children() - 1U), *sibling.node);
+  }
+
+  sibling.key = Ops::unify(sibling.key, child.key);
+  sibling.node->set_dirty(sibling.node->dirty() || from.dirty());
+  siblings.pop_at(index);
+  return true;
+}
+
+template<class B, class K, class D, class C>
+auto
+RTree<B, K, D, C>::remove(data_iterator& i) -> DatEntry
+{
+  assert(!i.empty());
+
+  // Drop leaf entry
+  auto entry = std::move(i.parent()->dat_children()[i.index()]);
+  i.parent()->dat_children().pop_at(i.index());
+  if (i.index() < i.parent()->num_children()) {
+    const auto gap = i.index(); // Last child moved here
+    placed(*i.parent(), gap, static_cast<ChildIndex>(gap + 1U));
+  }
+
+  i.step_up();
+  if (--_size == 0U) {
+    clear();
+    return entry;
+  }
+
+  // Condense tree by re-inserting any under-full directory nodes
+  condense_tree(i);
+
+  assert(!(_root.node->child_type() == NodeType::directory &&
+           _root.node->num_children() == 1));
+
+  return entry;
+}
+
+template<class B, class K, class D, class C>
+template<class S>
+auto
+RTree<B, K, D, C>::query(S search) const -> TreeRange<ConstSearcher<S>>
+{
+  if (empty()) {
+    return {{{Box{}, nullptr}, search}, {{Box{}, nullptr}, search}};
+  }
+
+  ConstSearcher<S> first{_root, search};
+  ConstSearcher<S> last{{Box{}, nullptr}, search};
+
+  assert(first == last || search.leaf(first->first));
+
+  return {std::move(first), std::move(last)};
+}
+
+template<class B, class K, class D, class C>
+template<class S>
+auto
+RTree<B, K, D, C>::query(S search) -> TreeRange<Searcher<S>>
+{
+  if (empty()) {
+    return {{{Box{}, nullptr}, search}, {{Box{}, nullptr}, search}};
+  }
+
+  Searcher<S> first{_root, search};
+  Searcher<S> last{{Box{}, nullptr}, search};
+
+  assert(first == last || search.leaf(first->first));
+
+  return {std::move(first), std::move(last)};
+}
+
+template<class B, class K, class D, class C>
+template<class Node>
+auto
+RTree<B, K, D, C>::cursor(
+  const EntryIterator<Node, max_height()>& i) const noexcept -> Cursor
+{
+  Cursor cursor{_version, i.depth(), {}};
+  for (unsigned d = 0U; d < cursor.depth; ++d) {
+    cursor.indexes[d] = i.index_at(d);
+  }
+
+  return cursor;
+}
+
+template<class B, class K, class D, class C>
+template<class DataIter, class Node>
+DataIter
+RTree<B, K, D, C>::follow(const Cursor& cursor, Node* const root) noexcept
+{
+  DataIter iter;
+
+  Node* node = root;
+  for (unsigned d = 0U; d < cursor.depth; ++d) {
+    const auto index = cursor.indexes[d];
+    const bool leaf  = (d + 1U == cursor.depth);
+    if (!node || index >= node->num_children() ||
+        (node->child_type() == NodeType::data) != leaf) {
+      return {};
+    }
+
+    iter.step_down(node, index);
+    if (!leaf) {
+      node = node->dir_children()[index].node.get();
+    }
+  }
+
+  return iter;
+}
+
+template<class B, class K, class D, class C>
+template<class S>
+auto
+RTree<B, K, D, C>::resume(const Cursor& cursor, S search) const
+  -> std::optional<TreeRange<ConstSearcher<S>>>
+{
+  if (cursor.version != _version) {
+    return std::nullopt;
+  }
+
+  ConstSearcher<S> last{{Box{}, nullptr}, search};
+  if (cursor.empty()) {
+    return TreeRange<ConstSearcher<S>>{last, last};
+  }
+
+  const DirNode* const root = _root.node.get();
+  const auto           base = follow<const_data_iterator>(cursor, root);
+  if (base.empty()) {
+    return std::nullopt;
+  }
+
+  return TreeRange<ConstSearcher<S>>{{base, search}, std::move(last)};
+}
+
+template<class B, class K, class D, class C>
+template<class S>
+auto
+RTree<B, K, D, C>::resume(const Cursor& cursor, S search)
+  -> std::optional<TreeRange<Searcher<S>>>
+{
+  if (cursor.version != _version) {
+    return std::nullopt;
+  }
+
+  Searcher<S> last{{Box{}, nullptr}, search};
+  if (cursor.empty()) {
+    return TreeRange<Searcher<S>>{last, last};
+  }
+
+  const auto base = follow<data_iterator>(cursor, _root.node.get());
+  if (base.empty()) {
+    return std::nullopt;
+  }
+
+  return TreeRange<Searcher<S>>{{base, search}, std::move(last)};
+}
+
+#if SPAIX_USE_COROUTINES
+template<class B, class K, class D, class C>
+template<unsigned batch_size, class S>
+auto
+RTree<B, K, D, C>::query_batches(S search) const
+  -> Generator<Batch<batch_size>>
+{
+  static_assert(batch_size);
+
+  Batch<batch_size> batch;
+  for (const auto& node : query(search)) {
+    batch.emplace_back(node);
+    if (batch.size() == batch_size) {
+      co_yield batch;
+      batch.clear();
+    }
+  }
+
+  if (batch.size()) {
+    co_yield batch;
+  }
+}
+#endif
+
+template<class B, class K, class D, class C>
+template<class Children>
+auto
+RTree<B, K, D, C>::parent_key(const Children& children) noexcept -> Box
+{
+  return std::accumulate(children.begin(),
+                         children.end(),
+                         Box{},
+                         [](const Box& box, const auto& entry) {
+                           return Ops::unify(box, detail::entry_key(entry));
+                         });
+}
+
+template<class B, class K, class D, class C>
+auto
+RTree<B, K, D, C>::ideal_key(const DirNode& node) noexcept -> Box
+{
+  if (node.child_type() == NodeType::directory) {
+    return parent_key(node.dir_children());
+  }
+
+  return parent_key(node.dat_children());
+}
+
+template<class B, class K, class D, class C>
+template<class Entry>
+auto
+RTree<B, K, D, C>::insert_leaf(DirNode& parent, Entry entry) noexcept
+  -> SplitParts<DirEntry, ChildIndex>
+{
+  if (parent.num_children() >= Conf::fanout(parent.child_type())) {
+    // Split insert
+    return split_node(parent, std::move(entry));
+  }
+
+  // Simple insert
+  SplitParts<DirEntry, ChildIndex> parts{};
+  parts.tracked_index = parent.num_children();
+  parent.append_child(std::move(entry));
+  return parts;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::condense_tree(entry_iterator& i) noexcept
+{
+  // Record the path from the root to the leaf to update summaries later
+  StaticVector<DirNode*, unsigned, max_height() + 1U> path;
+  if constexpr (DirNode::summarized) {
+    for (unsigned d = 0U; d < i.depth(); ++d) {
+      path.emplace_back(i.parent_at(d));
+    }
+    path.emplace_back(i.empty() ? _root.node.get()
+                                : i.at(i.depth() - 1U).node.get());
+  }
+
+  // Condense upwards by removing under-filled directory nodes
+  StaticVector<std::unique_ptr<DirNode>, unsigned, max_height()> removed;
+  bool condensing = true;
+  for (; !i.empty() && condensing; i.step_up()) {
+    auto& e = i.parent()->dir_children()[i.index()];
+    if (e.node->num_children() < Conf::min_fanout(e.node->child_type())) {
+      if constexpr (!std::is_same_v<Underflow, ReinsertUnderflow>) {
+        if (i.parent()->num_children() > 1U) {
+          // Merge this entry's node with a sibling, or refill it, and continue
+          if (merge_child(*i.parent(), i.index())) {
+            while (path.size() > i.depth()) {
+              path.pop_back();
+            }
+          }
+          continue;
+        }
+      }
+
+      // This entry's node is under-filled, remove it and continue
+      removed.emplace_back(std::move(e.node));
+      i.parent()->dir_children().pop_at(i.index());
+      while (path.size() > i.depth()) {
+        path.pop_back();
+      }
+    } else {
+      // Recompute this entry's key and continue if it shrank
+      const auto new_key = ideal_key(*e.node);
+      condensing         = (new_key != e.key);
+      if (condensing) {
+        e.key = new_key;
+      }
+    }
+  }
+
+  // Shrink the root key if necessary
+  if (condensing) {
+    assert(i.empty() || i.parent() == _root.node.get());
+    _root.key = ideal_key(*_root.node);
+  }
+  assert(Ops::unify(_root.key, ideal_key(*_root.node)) == _root.key);
+
+  // Update the summaries of the remaining path from the bottom up
+  for (auto n = path.size(); n > 0U; --n) {
+    path[n - 1U]->update_summary();
+  }
+
+  // Reinsert the children of all the removed directories
+  for (auto h = 0U; h < removed.size(); ++h) {
+    if (removed[h]->child_type() == NodeType::directory) {
+      reinsert_children(h, removed[h]->dir_children());
+    } else {
+      reinsert_children(h, removed[h]->dat_children());
+    }
+  }
+
+  // Remove superfluous root if possible
+  if (_root.node->child_type() == NodeType::directory &&
+      _root.node->num_children() == 1) {
+    _root = std::move(_root.node->dir_children()[0]);
+    _root.node->set_parent(nullptr);
+    --_height;
+  }
+}
+
+template<class B, class K, class D, class C>
+bool
+RTree<B, K, D, C>::merge_child(DirNode& parent, const ChildIndex index) noexcept
+{
+  auto        siblings = parent.dir_children();
+  auto&       child    = siblings[index];
+  auto&       sibling  = siblings[Underflow::choose_sibling(siblings, index)];
+  const auto  type     = child.node->child_type();
+  const auto& from     = child.node;
+
+  if (from->num_children() + sibling.node->num_children() <=
+      Conf::fanout(type)) {
+    // Move everything into the sibling and drop the child
+    while (from->num_children()) {
+      move_child(*from,
+                 static_cast<ChildIndex>(from->num_children() - 1U),
+                 *sibling.node);
+    }
+
+    sibling.key = Ops::unify(sibling.key, child.key);
+    siblings.pop_at(index);
+    return true;
+  }
+
+  // Refill the child with the entries of the sibling that enlarge it least
+  while (from->num_children() < Conf::min_fanout(type)) {
+    const auto c = (type == NodeType::directory)
+                     ? Underflow::choose_entry(sibling.node->dir_children(),
+                                               child.key)
+                     : Underflow::choose_entry(sibling.node->dat_children(),
+                                               child.key);
+
+    move_child(*sibling.node, c, *from);
+    child.key = ideal_key(*from);
+  }
+
+  sibling.key = ideal_key(*sibling.node);
+  sibling.node->update_summary();
+  return false;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::move_child(DirNode&         src,
+                              const ChildIndex c,
+                              DirNode&         dst) noexcept
+{
+  if (src.child_type() == NodeType::directory) {
+    auto children = src.dir_children();
+    dst.append_child(std::move(children[c]));
+    children.pop_at(c);
+  } else {
+    auto children = src.dat_children();
+    dst.append_child(std::move(children[c]));
+    children.pop_at(c);
+    placed(dst,
+           static_cast<ChildIndex>(dst.num_children() - 1U),
+           dst.num_children());
+    if (c < children.size()) {
+      placed(src, c, static_cast<ChildIndex>(c + 1U)); // Last moved here
+    }
+  }
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::loosen(entry_iterator i, const Box& bounds) noexcept
+{
+  if (i.empty()) {
+    return; // The root key is only a summary, so a root leaf stays tight
+  }
+
+  // Enlarge directory keys upwards until they already contain the bounds
+  for (; !i.empty(); i.step_up()) {
+    auto&      e       = i.parent()->dir_children()[i.index()];
+    const auto new_key = Ops::unify(e.key, bounds);
+    if (new_key == e.key) {
+      return;
+    }
+
+    e.key = new_key;
+  }
+
+  _root.key = Ops::unify(_root.key, bounds);
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches(const Predicate& predicate,
+                                 const Visitor&   visitor) const noexcept
+{
+  if (_root.node && detail::dir_matches(predicate, _root)) {
+    visit_matches_rec(*_root.node, predicate, visitor);
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches_rec(const DirNode&   node,
+                                     const Predicate& predicate,
+                                     const Visitor&   visitor) const noexcept
+{
+  if (_recording) {
+    node.add_visit();
+  }
+
+  if (node.child_type() == NodeType::directory) {
+    for (const auto& entry : node.dir_children()) {
+      if (detail::dir_matches(predicate, entry)) {
+        visit_matches_rec(*entry.node, predicate, visitor);
+      }
+    }
+  } else {
+    for (const auto& entry : node.dat_children()) {
+      if (detail::dat_matches<DirNode>(predicate, entry)) {
+        visitor(detail::entry_ref(entry));
+      }
+    }
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches_batched(
+  const Predicate& predicate,
+  const Visitor&   visitor) const noexcept
+{
+  if (_root.node && detail::dir_matches(predicate, _root)) {
+    visit_matches_batched_rec(*_root.node, predicate, visitor);
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches_batched_rec(
+  const DirNode&   node,
+  const Predicate& predicate,
+  const Visitor&   visitor) const noexcept
+{
+  if (_recording) {
+    node.add_visit();
+  }
+
+  if (node.child_type() == NodeType::directory) {
+    for (const auto& entry : node.dir_children()) {
+      if (detail::dir_matches(predicate, entry)) {
+        visit_matches_batched_rec(*entry.node, predicate, visitor);
+      }
+    }
+    return;
+  }
+
+  constexpr bool inlined = DirNode::placement == DataPlacement::inlined;
+
+  // Find the first child that doesn't match
+  const auto  children = node.dat_children();
+  ChildCount  n_prefix = 0U;
+  while (n_prefix < children.size() &&
+         detail::dat_matches<DirNode>(predicate, children[n_prefix])) {
+    ++n_prefix;
+  }
+
+  // Visit the children in place if they all match
+  if constexpr (inlined) {
+    if (n_prefix == children.size()) {
+      visitor(BatchView{n_prefix, children.begin()});
+      return;
+    }
+  }
+
+  // Gather the matches into a buffer
+  StaticVector<BatchElement, ChildCount, Conf::dat_fanout> batch;
+  for (ChildCount i = 0U; i < children.size(); ++i) {
+    const auto& entry = children[i];
+    if (i < n_prefix || (i > n_prefix &&
+                         detail::dat_matches<DirNode>(predicate, entry))) {
+      if constexpr (inlined) {
+        batch.emplace_back(entry);
+      } else {
+        batch.emplace_back(entry.get());
+      }
+    }
+  }
+
+  if (batch.size()) {
+    const auto n_matches = batch.size();
+    visitor(BatchView{n_matches, batch.begin()});
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches_parallel(const Predicate&      predicate,
+                                          std::vector<Visitor>& visitors) const
+{
+  if (visitors.empty() || !_root.node ||
+      !detail::dir_matches(predicate, _root)) {
+    return;
+  }
+
+  // Split the upper levels into tasks until there are enough for balance
+  const size_t                min_tasks = visitors.size() * 4U;
+  std::vector<const DirNode*> tasks{_root.node.get()};
+  while (!tasks.empty() && tasks.size() < min_tasks &&
+         tasks.front()->child_type() == NodeType::directory) {
+    std::vector<const DirNode*> children;
+    for (const auto* const node : tasks) {
+      for (const auto& entry : node->dir_children()) {
+        if (detail::dir_matches(predicate, entry)) {
+          children.emplace_back(entry.node.get());
+        }
+      }
+    }
+
+    tasks = std::move(children);
+  }
+
+  // Visit subtrees until there are no tasks left
+  std::atomic<size_t> next_task{0U};
+  const auto          work = [&](Visitor& visitor) {
+    const auto ref = std::ref(visitor);
+    for (auto t = next_task++; t < tasks.size(); t = next_task++) {
+      visit_matches_rec(*tasks[t], predicate, ref);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(visitors.size() - 1U);
+  for (size_t v = 1U; v < visitors.size(); ++v) {
+    threads.emplace_back(work, std::ref(visitors[v]));
+  }
+
+  work(visitors.front());
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches_batch(const std::vector<Predicate>& predicates,
+                                       std::vector<Visitor>& visitors) const
+{
+  if (visitors.empty() || !_root.node) {
+    return;
+  }
+
+  // Sort queries by the path to their first possibly matching leaf
+  std::vector<NodePath> paths;
+  paths.reserve(predicates.size());
+  for (const auto& predicate : predicates) {
+    paths.emplace_back(locality(predicate));
+  }
+
+  std::vector<size_t> order(predicates.size());
+  std::iota(order.begin(), order.end(), size_t(0U));
+  std::stable_sort(order.begin(), order.end(), [&paths](auto l, auto r) {
+    return paths[l] < paths[r];
+  });
+
+  // Run consecutive queries in order until there are none left
+  const size_t run_size =
+    std::max(size_t(1U), order.size() / (visitors.size() * 16U));
+
+  std::atomic<size_t> next_run{0U};
+  const auto          work = [&](Visitor& visitor) {
+    for (auto r = next_run++; r * run_size < order.size(); r = next_run++) {
+      const auto end = std::min(order.size(), (r + 1U) * run_size);
+      for (auto o = r * run_size; o < end; ++o) {
+        const auto  q         = order[o];
+        const auto& predicate = predicates[q];
+        if (detail::dir_matches(predicate, _root)) {
+          visit_matches_rec(*_root.node,
+                            predicate,
+                            [&visitor, q](const auto& node) {
+                              visitor(q, node);
+                            });
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(visitors.size() - 1U);
+  for (size_t v = 1U; v < visitors.size(); ++v) {
+    threads.emplace_back(work, std::ref(visitors[v]));
+  }
+
+  work(visitors.front());
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate>
+auto
+RTree<B, K, D, C>::locality(const Predicate& predicate) const noexcept
+  -> NodePath
+{
+  NodePath    path;
+  const auto* node = _root.node.get();
+  while (node && node->child_type() == NodeType::directory) {
+    const auto  children = node->dir_children();
+    const auto* next     = static_cast<const DirNode*>(nullptr);
+    for (ChildIndex i = 0U; i < children.size() && !next; ++i) {
+      if (detail::dir_matches(predicate, children[i])) {
+        path.emplace_back(i);
+        next = children[i].node.get();
+      }
+    }
+
+    node = next;
+  }
+
+  return path;
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Visitor, class Budget>
+void
+RTree<B, K, D, C>::visit_matches(const Predicate& predicate,
+                                 const Visitor&   visitor,
+                                 Budget&          budget,
+                                 Progress&        progress) const noexcept
+{
+  auto& pending = progress.pending;
+  if (!progress.started) {
+    progress.started = true;
+    if (_root.node && detail::dir_matches(predicate, _root)) {
+      pending.emplace_back(&_root);
+    }
+  }
+
+  while (!pending.empty() && budget.spend()) {
+    const DirNode& node = *pending.back()->node;
+    pending.pop_back();
+
+    if (node.child_type() == NodeType::directory) {
+      // Push matching children so that the most populous is visited next
+      const auto first = pending.size();
+      for (const auto& entry : node.dir_children()) {
+        if (detail::dir_matches(predicate, entry)) {
+          pending.emplace_back(&entry);
+        }
+      }
+
+      std::sort(pending.begin() + first,
+                pending.end(),
+                [](const DirEntry* const lhs, const DirEntry* const rhs) {
+                  return lhs->node->num_children() < rhs->node->num_children();
+                });
+    } else {
+      for (const auto& entry : node.dat_children()) {
+        if (detail::dat_matches<DirNode>(predicate, entry)) {
+          visitor(detail::entry_ref(entry));
+        }
+      }
+    }
+  }
+}
+
+template<class B, class K, class D, class C>
+template<size_t dim, class Predicate, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches_sorted(const Predicate& predicate,
+                                        const Visitor&   visitor) const
+{
+  using Bound = decltype(Ops::template lower<dim>(std::declval<const Box&>()));
+
+  // An entry on the search frontier, either a directory or a data node
+  struct Pending {
+    Bound          bound;
+    const DirNode* dir;
+    const DatNode* dat;
+  };
+
+  constexpr auto later = [](const Pending& lhs, const Pending& rhs) {
+    return rhs.bound < lhs.bound;
+  };
+
+  std::vector<Pending> heap;
+  if (_root.node && detail::dir_matches(predicate, _root)) {
+    heap.push_back({Ops::template lower<dim>(_root.key), _root.node.get(), {}});
+  }
+
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), later);
+    const Pending top = heap.back();
+    heap.pop_back();
+
+    if (top.dat) {
+      if (visitor(*top.dat) == VisitStatus::finish) {
+        return;
+      }
+    } else if (top.dir->child_type() == NodeType::directory) {
+      for (const auto& entry : top.dir->dir_children()) {
+        if (detail::dir_matches(predicate, entry)) {
+          heap.push_back(
+            {Ops::template lower<dim>(entry.key), entry.node.get(), {}});
+          std::push_heap(heap.begin(), heap.end(), later);
+        }
+      }
+    } else {
+      for (const auto& entry : top.dir->dat_children()) {
+        const auto& key = detail::entry_key(entry);
+        if (detail::dat_matches<DirNode>(predicate, entry)) {
+          heap.push_back(
+            {Ops::template lower<dim>(key), {}, &detail::entry_ref(entry)});
+          std::push_heap(heap.begin(), heap.end(), later);
+        }
+      }
+    }
+  }
+}
+
+namespace detail {
+
+template<class Ops, class Lhs, class Rhs, size_t n_dims>
+constexpr bool
+dominates_rec(const Lhs&, const Rhs&, const bool strict, EndIndex<n_dims>)
+{
+  return strict;
+}
+
+/// Return true iff the lower corner of `lhs` dominates that of `rhs`
+template<class Ops, class Lhs, class Rhs, size_t dim, size_t n_dims>
+constexpr bool
+dominates_rec(const Lhs&               lhs,
+              const Rhs&               rhs,
+              const bool               strict,
+              const Index<dim, n_dims> index)
+{
+  const auto l = Ops::template lower<dim>(lhs);
+  const auto r = Ops::template lower<dim>(rhs);
+
+  return !(r < l) && dominates_rec<Ops>(lhs, rhs, strict || l < r, ++index);
+}
+
+template<class Ops, class Lhs, class Rhs, size_t n_dims>
+constexpr bool
+lower_corner_less_rec(const Lhs&, const Rhs&, EndIndex<n_dims>)
+{
+  return false;
+}
+
+/// Return true iff the lower corner of `lhs` is lexicographically less
+template<class Ops, class Lhs, class Rhs, size_t dim, size_t n_dims>
+constexpr bool
+lower_corner_less_rec(const Lhs&               lhs,
+                      const Rhs&               rhs,
+                      const Index<dim, n_dims> index)
+{
+  const auto l = Ops::template lower<dim>(lhs);
+  const auto r = Ops::template lower<dim>(rhs);
+
+  return l < r || (!(r < l) && lower_corner_less_rec<Ops>(lhs, rhs, ++index));
+}
+
+} // namespace detail
+
+namespace detail {
+
+template<class Ops, class Key, class Resolution, size_t n_dims>
+constexpr bool
+extent_within_rec(const Key&, const Resolution&, EndIndex<n_dims>) noexcept
+{
+  return true;
+}
+
+/// Return true iff the extent of `key` is at most `resolution` everywhere
+template<class Ops, class Key, class Resolution, size_t dim, size_t n_dims>
+constexpr bool
+extent_within_rec(const Key&               key,
+                  const Resolution&        resolution,
+                  const Index<dim, n_dims> index) noexcept
+{
+  return !(resolution <
+           (Ops::template upper<dim>(key) - Ops::template lower<dim>(key))) &&
+         extent_within_rec<Ops>(key, resolution, ++index);
+}
+
+} // namespace detail
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Resolution, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches_sampled(
+  const Predicate&  predicate,
+  const Resolution& resolution,
+  const Visitor&    visitor) const noexcept
+{
+  if (_root.node && detail::dir_matches(predicate, _root)) {
+    visit_matches_sampled_rec(
+      *_root.node, _root.key, predicate, resolution, visitor);
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Resolution, class Visitor>
+void
+RTree<B, K, D, C>::visit_matches_sampled_rec(
+  const DirNode&    node,
+  const Box&        key,
+  const Predicate&  predicate,
+  const Resolution& resolution,
+  const Visitor&    visitor) const noexcept
+{
+  using Begin = detail::Index<0U, Box::size()>;
+
+  if (detail::extent_within_rec<Ops>(key, resolution, Begin{})) {
+    // Directory is small enough, visit the first match as a representative
+    visit_nearby_rec(node, predicate, [&visitor](const DatNode& n) {
+      visitor(n);
+      return VisitStatus::finish;
+    });
+  } else if (node.child_type() == NodeType::directory) {
+    for (const auto& entry : node.dir_children()) {
+      if (detail::dir_matches(predicate, entry)) {
+        visit_matches_sampled_rec(
+          *entry.node, entry.key, predicate, resolution, visitor);
+      }
+    }
+  } else {
+    for (const auto& entry : node.dat_children()) {
+      if (detail::dat_matches<DirNode>(predicate, entry)) {
+        visitor(detail::entry_ref(entry));
+      }
+    }
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class S>
+auto
+RTree<B, K, D, C>::skyline(const S& search) const
+  -> std::vector<const DatNode*>
+{
+  using Begin = detail::Index<0U, Box::size()>;
+
+  // An entry on the search frontier, either a directory or a data node
+  struct Pending {
+    Box            corner;
+    const DirNode* dir;
+    const DatNode* dat;
+  };
+
+  constexpr auto later = [](const Pending& lhs, const Pending& rhs) {
+    return detail::lower_corner_less_rec<Ops>(rhs.corner, lhs.corner, Begin{});
+  };
+
+  std::vector<const DatNode*> result;
+  const auto                  dominated = [&result](const auto& key) {
+    return std::any_of(
+      result.begin(), result.end(), [&key](const DatNode* const node) {
+        return detail::dominates_rec<Ops>(node->first, key, false, Begin{});
+      });
+  };
+
+  std::vector<Pending> heap;
+  if (_root.node && detail::dir_matches(search, _root)) {
+    heap.push_back({_root.key, _root.node.get(), {}});
+  }
+
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), later);
+    const Pending top = heap.back();
+    heap.pop_back();
+
+    if (dominated(top.corner)) {
+      continue;
+    }
+
+    if (top.dat) {
+      result.push_back(top.dat);
+    } else if (top.dir->child_type() == NodeType::directory) {
+      for (const auto& entry : top.dir->dir_children()) {
+        if (detail::dir_matches(search, entry) && !dominated(entry.key)) {
+          heap.push_back({entry.key, entry.node.get(), {}});
+          std::push_heap(heap.begin(), heap.end(), later);
+        }
+      }
+    } else {
+      for (const auto& entry : top.dir->dat_children()) {
+        const auto& key = detail::entry_key(entry);
+        if (detail::dat_matches<DirNode>(search, entry) && !dominated(key)) {
+          heap.push_back({Box{key}, {}, &detail::entry_ref(entry)});
+          std::push_heap(heap.begin(), heap.end(), later);
+        }
+      }
+    }
+  }
+
+  return result;
+}
+
+namespace detail {
+
+template<class Ops, bool upper, class Key, class Window, size_t n_dims>
+size_t
+grid_cell_rec(const Key&,
+              const Window&,
+              const size_t,
+              const size_t,
+              EndIndex<n_dims>) noexcept
+{
+  return 0U;
+}
+
+/**
+   Return the index of the grid cell that contains a corner of `key`.
+
+   Returns `SIZE_MAX` if the corner is outside the window.
+*/
+template<class Ops,
+         bool upper,
+         class Key,
+         class Window,
+         size_t dim,
+         size_t n_dims>
+size_t
+grid_cell_rec(const Key&               key,
+              const Window&            window,
+              const size_t             cells_per_dim,
+              const size_t             stride,
+              const Index<dim, n_dims> index) noexcept
+{
+  const auto value = upper ? Ops::template upper<dim>(key)
+                           : Ops::template lower<dim>(key);
+
+  const auto window_lower = Ops::template lower<dim>(window);
+  const auto window_upper = Ops::template upper<dim>(window);
+  if (value < window_lower || window_upper < value) {
+    return SIZE_MAX;
+  }
+
+  const auto offset = static_cast<double>(value - window_lower);
+  const auto span   = static_cast<double>(window_upper - window_lower);
+  const auto cell =
+    (span > 0.0)
+      ? std::min(static_cast<size_t>(offset / span *
+                                     static_cast<double>(cells_per_dim)),
+                 cells_per_dim - 1U)
+      : size_t{};
+
+  const auto rest = grid_cell_rec<Ops, upper>(
+    key, window, cells_per_dim, stride * cells_per_dim, ++index);
+
+  return (rest == SIZE_MAX) ? SIZE_MAX : (cell * stride) + rest;
+}
+
+template<class Ops, class Lhs, class Rhs, size_t n_dims>
+constexpr bool
+overlaps_rec(const Lhs&, const Rhs&, EndIndex<n_dims>) noexcept
+{
+  return true;
+}
+
+/// Return true iff the ranges of `lhs` and `rhs` overlap in every dimension
+template<class Ops, class Lhs, class Rhs, size_t dim, size_t n_dims>
+constexpr bool
+overlaps_rec(const Lhs&               lhs,
+             const Rhs&               rhs,
+             const Index<dim, n_dims> index) noexcept
+{
+  return !(Ops::template upper<dim>(lhs) < Ops::template lower<dim>(rhs)) &&
+         !(Ops::template upper<dim>(rhs) < Ops::template lower<dim>(lhs)) &&
+         overlaps_rec<Ops>(lhs, rhs, ++index);
+}
+
+} // namespace detail
+
+template<class B, class K, class D, class C>
+auto
+RTree<B, K, D, C>::histogram(const Box&   window,
+                             const size_t cells_per_dim) const
+  -> std::vector<size_t>
+{
+  using Begin = detail::Index<0U, Box::size()>;
+
+  std::vector<size_t> counts(detail::power<size_t>(cells_per_dim, Box::size()));
+
+  if (_root.node && cells_per_dim &&
+      detail::overlaps_rec<Ops>(_root.key, window, Begin{})) {
+    histogram_rec(*_root.node, _root.key, window, cells_per_dim, counts);
+  }
+
+  return counts;
+}
+
+template<class B, class K, class D, class C>
+void
+RTree<B, K, D, C>::histogram_rec(const DirNode&       node,
+                                 const Box&           key,
+                                 const Box&           window,
+                                 const size_t         cells_per_dim,
+                                 std::vector<size_t>& counts) const
+{
+  using Begin = detail::Index<0U, Box::size()>;
+
+  // Count the whole subtree at once if every lower corner is in the same cell
+  const auto lower_cell =
+    detail::grid_cell_rec<Ops, false>(key, window, cells_per_dim, 1U, Begin{});
+  if (lower_cell != SIZE_MAX &&
+      lower_cell == detail::grid_cell_rec<Ops, true>(
+                      key, window, cells_per_dim, 1U, Begin{})) {
+    counts[lower_cell] += subtree_size(node);
+    return;
+  }
+
+  if (node.child_type() == NodeType::directory) {
+    for (const auto& entry : node.dir_children()) {
+      if (detail::overlaps_rec<Ops>(entry.key, window, Begin{})) {
+        histogram_rec(*entry.node, entry.key, window, cells_per_dim, counts);
+      }
+    }
+  } else {
+    for (const auto& entry : node.dat_children()) {
+      const auto cell = detail::grid_cell_rec<Ops, false>(
+        detail::entry_key(entry), window, cells_per_dim, 1U, Begin{});
+      if (cell != SIZE_MAX) {
+        ++counts[cell];
+      }
+    }
+  }
+}
+
+template<class B, class K, class D, class C>
+size_t
+RTree<B, K, D, C>::subtree_size(const DirNode& node) noexcept
+{
+  if (node.child_type() == NodeType::data) {
+    return node.num_children();
+  }
+
+  size_t count = 0U;
+  for (const auto& entry : node.dir_children()) {
+    count += subtree_size(*entry.node);
+  }
+
+  return count;
+}
+
+namespace detail {
+
+/// Return true iff the matches of two predicates may differ within an entry
+template<class Previous, class Next, class DirEntry>
+bool
+may_differ(const Previous& previous,
+           const Next&     next,
+           const DirEntry& entry) noexcept
+{
+  return (dir_matches(next, entry) && !dir_covers(previous, entry)) ||
+         (dir_matches(previous, entry) && !dir_covers(next, entry));
+}
+
+} // namespace detail
+
+template<class B, class K, class D, class C>
+template<class Previous, class Next, class EnteredVisitor, class LeftVisitor>
+void
+RTree<B, K, D, C>::visit_delta(const Previous&       previous,
+                               const Next&           next,
+                               const EnteredVisitor& visit_entered,
+                               const LeftVisitor&    visit_left) const noexcept
+{
+  if (_root.node && detail::may_differ(previous, next, _root)) {
+    visit_delta_rec(*_root.node, previous, next, visit_entered, visit_left);
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Previous, class Next, class EnteredVisitor, class LeftVisitor>
+void
+RTree<B, K, D, C>::visit_delta_rec(const DirNode&        node,
+                                   const Previous&       previous,
+                                   const Next&           next,
+                                   const EnteredVisitor& entered,
+                                   const LeftVisitor&    left) const noexcept
+{
+  if (node.child_type() == NodeType::directory) {
+    for (const auto& entry : node.dir_children()) {
+      if (detail::may_differ(previous, next, entry)) {
+        visit_delta_rec(*entry.node, previous, next, entered, left);
+      }
+    }
+  } else {
+    for (const auto& entry : node.dat_children()) {
+      const bool was_in = detail::dat_matches<DirNode>(previous, entry);
+      const bool is_in  = detail::dat_matches<DirNode>(next, entry);
+      if (is_in && !was_in) {
+        entered(detail::entry_ref(entry));
+      } else if (was_in && !is_in) {
+        left(detail::entry_ref(entry));
+      }
+    }
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class FingerNode, class Predicate, class Visitor>
+void
+RTree<B, K, D, C>::visit_nearby(
+  const EntryIterator<FingerNode, max_height()>& finger,
+  const Box&                                     window,
+  const Predicate&                               predicate,
+  const Visitor&                                 visitor) const noexcept
+{
+  // Climb from the finger's leaf to the first directory that contains window
+  const DirEntry* entry = &_root;
+  for (unsigned d = finger.depth(); d > 1U; --d) {
+    const auto& e = finger.at(d - 2U);
+    if (Ops::unify(e.key, window) == e.key) {
+      entry = &e;
+      break;
+    }
+  }
+
+  if (entry->node && detail::dir_matches(predicate, *entry)) {
+    visit_nearby_rec(*entry->node, predicate, visitor);
+  }
+}
+
+template<class B, class K, class D, class C>
+template<class Predicate, class Visitor>
+VisitStatus
+RTree<B, K, D, C>::visit_nearby_rec(const DirNode&   node,
+                                    const Predicate& predicate,
+                                    const Visitor&   visitor) const noexcept
+{
+  if (node.child_type() == NodeType::directory) {
+    for (const auto& entry : node.dir_children()) {
+      if (detail::dir_matches(predicate, entry) &&
+          visit_nearby_rec(*entry.node, predicate, visitor) ==
+            VisitStatus::finish) {
+        return VisitStatus::finish;
+      }
+    }
+  } else {
+    for (const auto& entry : node.dat_children()) {
+      if (detail::dat_matches<DirNode>(predicate, entry) &&
+          visitor(detail::entry_ref(entry)) == VisitStatus::finish) {
+        return VisitStatus::finish;
+      }
+    }
+  }
+
+  return VisitStatus::proceed;
+}
+
 /// Create a new parent seeded with a child
 template<class B, class K, class D, class C>
 template<class Entry, class Count, Count count>
@@ -0,0 +1,25 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_REINSERTUNDERFLOW_HPP
+#define SPAIX_REINSERTUNDERFLOW_HPP
+
+namespace spaix {
+
+/**
+   Underflow handling by removing the node and reinserting its children.
+
+   An underflow policy decides what happens to a node that becomes
+   under-filled after an erasure, and is set with the `UnderflowPolicy`
+   parameter of spaix::Config.  This is the default, which removes the node
+   and reinserts all of its children from the top of the tree, as described
+   by Guttman.  This tends to improve the tree, since children can find
+   better places, but reinsertion can be slow, and may cause splits.
+
+   See spaix::MergeUnderflow for an alternative.
+*/
+struct ReinsertUnderflow {};
+
+} // namespace spaix
+
+#endif // SPAIX_REINSERTUNDERFLOW_HPP
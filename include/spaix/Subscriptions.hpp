@@ -0,0 +1,149 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_SUBSCRIPTIONS_HPP
+#define SPAIX_SUBSCRIPTIONS_HPP
+
+#include <spaix/NullObserver.hpp>
+#include <spaix/RTree.hpp>
+#include <spaix/search/Exactly.hpp>
+
+#include <cstddef>
+#include <utility>
+
+namespace spaix {
+
+/// A change in whether an item is within a subscribed region
+enum class SubscriptionEvent : unsigned char {
+  entered, ///< Item entered the region
+  left,    ///< Item left the region
+};
+
+/**
+   A registry of standing queries that are notified when items move.
+
+   This is a tree observer (see spaix::NullObserver) which keeps its own
+   spatial index of subscribed regions.  When an item in the observed tree is
+   inserted, erased, or relocated, the regions it enters or leaves are found
+   in this index, and the handler is called once for each.
+
+   An item is within a region if its key intersects the region.
+
+   @tparam Comparisons Geometric comparisons between regions and item keys.
+
+   @tparam IndexConf Configuration (a spaix::Config) for the region index.
+
+   @tparam Handler Function called like `handler(id, event, data_node)` with a
+   subscription ID, a spaix::SubscriptionEvent, and an item in the observed
+   tree.  This must not throw.
+*/
+template<class Comparisons, class IndexConf, class Handler>
+class Subscriptions : public NullObserver
+{
+public:
+  using Region = typename Comparisons::Box; ///< Subscribed area
+  using Id     = size_t;                    ///< Subscription identifier
+  using Index  = RTree<Region, Region, Id, IndexConf>;
+
+  explicit Subscriptions(Handler handler) noexcept
+    : _handler{std::move(handler)}
+  {}
+
+  /// Subscribe to items entering or leaving `region`
+  Id subscribe(const Region& region)
+  {
+    const auto id = _next_id++;
+    _index.insert(region, id);
+    return id;
+  }
+
+  /// Cancel a subscription and return true, or return false if not found
+  bool unsubscribe(const Region& region, const Id id)
+  {
+    auto matches = _index.query(search::Exactly<Comparisons, Region>{region});
+    for (auto& i = matches.begin(); i != matches.end(); ++i) {
+      if (i->second == id) {
+        _index.erase(i);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// Return the number of active subscriptions
+  [[nodiscard]] size_t size() const noexcept { return _index.size(); }
+
+  /// Return true iff there are no active subscriptions
+  [[nodiscard]] bool empty() const noexcept { return _index.empty(); }
+
+  /// Return the spatial index of subscribed regions
+  [[nodiscard]] const Index& index() const noexcept { return _index; }
+
+  template<class DatNode>
+  void inserted(const DatNode& node) noexcept
+  {
+    notify(node.first, SubscriptionEvent::entered, node);
+  }
+
+  template<class DatNode>
+  void erased(const DatNode& node) noexcept
+  {
+    notify(node.first, SubscriptionEvent::left, node);
+  }
+
+  template<class Key, class DatNode>
+  void relocated(const Key& old_key, const DatNode& node) noexcept
+  {
+    const auto& new_key = node.first;
+
+    _index.visit_matches(Hits<Key>{old_key}, [&](const auto& subscription) {
+      if (!Comparisons::intersects(subscription.first, new_key)) {
+        _handler(subscription.second, SubscriptionEvent::left, node);
+      }
+    });
+
+    _index.visit_matches(Hits<Key>{new_key}, [&](const auto& subscription) {
+      if (!Comparisons::intersects(subscription.first, old_key)) {
+        _handler(subscription.second, SubscriptionEvent::entered, node);
+      }
+    });
+  }
+
+private:
+  /// Predicate that matches regions which intersect an item key
+  template<class Key>
+  struct Hits {
+    template<class DirKey>
+    [[nodiscard]] bool directory(const DirKey& k) const noexcept
+    {
+      return Comparisons::intersects(k, key);
+    }
+
+    template<class DatKey>
+    [[nodiscard]] bool leaf(const DatKey& k) const noexcept
+    {
+      return Comparisons::intersects(k, key);
+    }
+
+    const Key& key;
+  };
+
+  template<class Key, class DatNode>
+  void notify(const Key&              key,
+              const SubscriptionEvent event,
+              const DatNode&          node) noexcept
+  {
+    _index.visit_matches(Hits<Key>{key}, [&](const auto& subscription) {
+      _handler(subscription.second, event, node);
+    });
+  }
+
+  Index   _index;
+  Handler _handler;
+  Id      _next_id{};
+};
+
+} // namespace spaix
+
+#endif // SPAIX_SUBSCRIPTIONS_HPP
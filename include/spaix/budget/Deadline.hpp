@@ -0,0 +1,34 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_BUDGET_DEADLINE_HPP
+#define SPAIX_BUDGET_DEADLINE_HPP
+
+#include <chrono>
+
+namespace spaix::budget {
+
+/// A budget that allows visiting nodes until a point in time
+template<class Clock = std::chrono::steady_clock>
+class Deadline
+{
+public:
+  using TimePoint = typename Clock::time_point;
+
+  explicit Deadline(const TimePoint deadline) noexcept
+    : _deadline{deadline}
+  {}
+
+  /// Spend one node, or return false if the deadline has passed
+  [[nodiscard]] bool spend() const noexcept { return Clock::now() < _deadline; }
+
+  /// Return the time after which no more nodes may be visited
+  [[nodiscard]] TimePoint deadline() const noexcept { return _deadline; }
+
+private:
+  TimePoint _deadline;
+};
+
+} // namespace spaix::budget
+
+#endif // SPAIX_BUDGET_DEADLINE_HPP
@@ -0,0 +1,42 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_BUDGET_NODES_HPP
+#define SPAIX_BUDGET_NODES_HPP
+
+#include <cstddef>
+
+namespace spaix::budget {
+
+/// A budget that allows visiting a limited number of nodes
+class Nodes
+{
+public:
+  explicit constexpr Nodes(const size_t n_nodes) noexcept
+    : _remaining{n_nodes}
+  {}
+
+  /// Spend one node, or return false if the budget is exhausted
+  [[nodiscard]] constexpr bool spend() noexcept
+  {
+    if (!_remaining) {
+      return false;
+    }
+
+    --_remaining;
+    return true;
+  }
+
+  /// Return the number of nodes that may still be visited
+  [[nodiscard]] constexpr size_t remaining() const noexcept
+  {
+    return _remaining;
+  }
+
+private:
+  size_t _remaining;
+};
+
+} // namespace spaix::budget
+
+#endif // SPAIX_BUDGET_NODES_HPP
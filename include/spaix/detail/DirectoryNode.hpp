@@ -5,26 +5,39 @@
 #define SPAIX_DETAIL_DIRECTORYNODE_HPP
 
 #include <spaix/ConstStaticVectorView.hpp>
+#include <spaix/NullSummary.hpp>
 #include <spaix/StaticVectorView.hpp>
 #include <spaix/detail/DatEntryType.hpp>
 #include <spaix/detail/NodePointerEntry.hpp>
+#include <spaix/detail/entry.hpp>
 #include <spaix/types.hpp>
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <utility>
 
 namespace spaix::detail {
 
-template<class Box, class DatNode, class Structure>
+template<class Box,
+         class DatNode,
+         class Structure,
+         class DataSummary = NullSummary>
 struct DirectoryNode {
 public:
   static constexpr auto placement  = Structure::placement;
   static constexpr auto dir_fanout = Structure::dir_fanout;
   static constexpr auto dat_fanout = Structure::dat_fanout;
 
+  using Summary = DataSummary;
+  using Mask    = typename Summary::Mask;
+
+  static constexpr bool summarized = !std::is_same_v<Summary, NullSummary>;
+
   using ChildCount = typename Structure::ChildCount;
   using ChildIndex = ChildCount;
 
@@ -32,7 +45,7 @@ public:
   using Data   = typename DatNode::second_type;
   using DirKey = Box;
 
-  using DirNode  = DirectoryNode<Box, DatNode, Structure>;
+  using DirNode  = DirectoryNode<Box, DatNode, Structure, Summary>;
   using DirEntry = NodePointerEntry<DirKey, DirNode>;
   using DatEntry = typename DatEntryType<DatNode, placement>::Type;
 
@@ -69,9 +82,31 @@ public:
     return DatEntryType<DatNode, placement>::make(key, data);
   }
 
+  /// Return the summary of the data in a data entry
+  static Mask entry_summary(const DatEntry& entry) noexcept
+  {
+    return Summary::summarize(entry_data(entry));
+  }
+
+  /// Return the summary of all the data beneath a directory entry
+  static const Mask& entry_summary(const DirEntry& entry) noexcept
+  {
+    return entry.node->summary();
+  }
+
+  /// Return whether a data entry has uncondensed erasures beneath it (never)
+  static bool entry_dirty(const DatEntry&) noexcept { return false; }
+
+  /// Return whether a directory entry has uncondensed erasures beneath it
+  static bool entry_dirty(const DirEntry& entry) noexcept
+  {
+    return entry.node->dirty();
+  }
+
   ChildCount append_child(DatEntry child) noexcept
   {
     assert(_child_type == NodeType::data);
+    add_summary(entry_summary(child));
     dat_children().emplace_back(std::move(child));
     return _size;
   }
@@ -80,10 +115,68 @@ public:
   {
     assert(_child_type == NodeType::directory);
     assert(entry.node);
+    add_summary(entry_summary(entry));
+    _dirty              = _dirty || entry.node->_dirty;
+    entry.node->_parent = this;
     dir_children().emplace_back(std::move(entry));
     return _size;
   }
 
+  /// Return the parent of this node, or null for the root
+  [[nodiscard]] DirNode* parent() const noexcept { return _parent; }
+
+  /// Set the parent of this node after moving it
+  void set_parent(DirNode* const parent) noexcept { _parent = parent; }
+
+  /// Return true if entries beneath this node were erased without condensing
+  [[nodiscard]] bool dirty() const noexcept { return _dirty; }
+
+  /// Set whether entries beneath this node were erased without condensing
+  void set_dirty(const bool dirty) noexcept { _dirty = dirty; }
+
+  /// Return the number of recorded query visits to this node
+  [[nodiscard]] uint32_t visits() const noexcept
+  {
+    return _visits.load(std::memory_order_relaxed);
+  }
+
+  /// Record a query visit to this node, which may be done by several threads
+  void add_visit() const noexcept
+  {
+    _visits.fetch_add(1U, std::memory_order_relaxed);
+  }
+
+  /// Reset the number of recorded query visits to this node
+  void reset_visits() noexcept { _visits.store(0U, std::memory_order_relaxed); }
+
+  /// Return the summary of all the data beneath this node
+  [[nodiscard]] const Mask& summary() const noexcept { return _summary; }
+
+  /// Merge a summary for data that was added beneath this node
+  void add_summary(const Mask& mask) noexcept
+  {
+    if constexpr (summarized) {
+      _summary |= mask;
+    }
+  }
+
+  /// Recompute the summary from the children of this node
+  void update_summary() noexcept
+  {
+    if constexpr (summarized) {
+      _summary = Mask{};
+      if (_child_type == NodeType::directory) {
+        for (const auto& child : dir_children()) {
+          _summary |= entry_summary(child);
+        }
+      } else {
+        for (const auto& child : dat_children()) {
+          _summary |= entry_summary(child);
+        }
+      }
+    }
+  }
+
   [[nodiscard]] ChildIndex num_children() const noexcept { return _size; }
 
   [[nodiscard]] ChildCount fanout() const noexcept
@@ -127,7 +220,13 @@ private:
     std::max(dir_fanout * sizeof(DirEntry), dat_fanout * sizeof(DatEntry));
 
   const NodeType _child_type; ///< Type of children nodes
+  bool           _dirty{};    ///< True if a descendant may need condensing
   ChildCount     _size{};     ///< Number of children nodes
+  DirNode*       _parent{};   ///< Parent node, or null for the root
+  Mask           _summary{};  ///< Summary of all data beneath this node
+
+  /// Number of recorded query visits, counted even by const queries
+  mutable std::atomic<uint32_t> _visits{};
 
   struct alignas(AnyEntry) Children {
     std::array<std::byte, n_children_bytes> bytes;
@@ -0,0 +1,76 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_DETAIL_MATCHES_HPP
+#define SPAIX_DETAIL_MATCHES_HPP
+
+#include <spaix/detail/entry.hpp>
+
+#include <type_traits>
+#include <utility>
+
+namespace spaix::detail {
+
+/// Whether a predicate has a `summary()` method for summaries of type `Mask`
+template<class Predicate, class Mask, class = void>
+struct HasSummaryCheck : std::false_type {};
+
+template<class Predicate, class Mask>
+struct HasSummaryCheck<Predicate,
+                       Mask,
+                       std::void_t<decltype(std::declval<const Predicate&>()
+                                              .summary(std::declval<Mask>()))>>
+  : std::true_type {};
+
+/// Return true iff a predicate may match something in a directory entry
+template<class Predicate, class DirEntry>
+bool
+dir_matches(const Predicate& predicate, const DirEntry& entry) noexcept
+{
+  using Mask = typename DirEntry::Node::Mask;
+
+  if constexpr (HasSummaryCheck<Predicate, Mask>::value) {
+    return predicate.directory(entry.key) &&
+           predicate.summary(entry.node->summary());
+  } else {
+    return predicate.directory(entry.key);
+  }
+}
+
+/// Return true iff a predicate matches a data entry in a `DirNode`
+template<class DirNode, class Predicate, class DatEntry>
+bool
+dat_matches(const Predicate& predicate, const DatEntry& entry) noexcept
+{
+  using Mask = typename DirNode::Mask;
+
+  if constexpr (HasSummaryCheck<Predicate, Mask>::value) {
+    return predicate.leaf(entry_key(entry)) &&
+           predicate.summary(DirNode::entry_summary(entry));
+  } else {
+    return predicate.leaf(entry_key(entry));
+  }
+}
+
+/**
+   Return true iff a predicate matches everything in a directory entry.
+
+   A summary only shows what may be beneath a directory, not that everything
+   does, so this is always false for predicates that check summaries.
+*/
+template<class Predicate, class DirEntry>
+bool
+dir_covers(const Predicate& predicate, const DirEntry& entry) noexcept
+{
+  using Mask = typename DirEntry::Node::Mask;
+
+  if constexpr (HasSummaryCheck<Predicate, Mask>::value) {
+    return false;
+  } else {
+    return predicate.covers(entry.key);
+  }
+}
+
+} // namespace spaix::detail
+
+#endif // SPAIX_DETAIL_MATCHES_HPP
@@ -18,6 +18,12 @@ struct Everything {
   {
     return true;
   }
+
+  template<class DirKey>
+  [[nodiscard]] static constexpr bool covers(const DirKey&) noexcept
+  {
+    return true;
+  }
 };
 
 } // namespace spaix::search
@@ -34,6 +34,12 @@ public:
     return _query_key == k;
   }
 
+  template<class DirKey>
+  [[nodiscard]] static constexpr bool covers(const DirKey&) noexcept
+  {
+    return false;
+  }
+
 private:
   std::decay_t<QueryKey> _query_key;
 };
@@ -34,6 +34,12 @@ public:
     return Comps::intersects(_query_key, k);
   }
 
+  template<class DirKey>
+  [[nodiscard]] constexpr bool covers(const DirKey& k) const noexcept
+  {
+    return Comps::contains(_query_key, k);
+  }
+
 private:
   std::decay_t<QueryKey> _query_key;
 };
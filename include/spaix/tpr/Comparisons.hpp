@@ -0,0 +1,112 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_TPR_COMPARISONS_HPP
+#define SPAIX_TPR_COMPARISONS_HPP
+
+#include <spaix/homox/Comparisons.hpp>
+#include <spaix/tpr/Point.hpp>
+#include <spaix/tpr/Rect.hpp>
+#include <spaix/tpr/Timeslice.hpp>
+#include <spaix/types.hpp>
+
+#include <cstddef>
+
+namespace spaix::tpr {
+
+/**
+   Comparisons between timeslice queries and time-parameterised keys.
+
+   Keys are compared with the query region at the query time, so the same
+   tree answers queries for any time from zero onwards without updates.
+*/
+template<class T, size_t D>
+struct Comparisons {
+  using Box = Timeslice<T, D>;
+
+  static constexpr bool contains(const Box& parent, const Point<T, D>& child)
+  {
+    for (size_t d = 0U; d < D; ++d) {
+      const auto& p = parent.region[d];
+      const auto  c = child[d].at(parent.time);
+
+      if ((c < p.lower) || (p.upper < c)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+  static constexpr bool contains(const Box& parent, const Rect<T, D>& child)
+  {
+    for (size_t d = 0U; d < D; ++d) {
+      const auto& p = parent.region[d];
+      const auto  c = child[d].at(parent.time);
+
+      if ((c.lower < p.lower) || (p.upper < c.upper)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /// Return true if timeslices are at the same time and regions contain
+  static constexpr bool contains(const Box& parent, const Box& child)
+  {
+    return parent.time == child.time &&
+           homox::Comparisons<T, D>::contains(parent.region, child.region);
+  }
+
+  static constexpr bool intersects(const Box& lhs, const Point<T, D>& rhs)
+  {
+    return contains(lhs, rhs);
+  }
+
+  static constexpr bool intersects(const Box& lhs, const Rect<T, D>& rhs)
+  {
+    for (size_t d = 0U; d < D; ++d) {
+      const auto& l = lhs.region[d];
+      const auto  r = rhs[d].at(lhs.time);
+
+      if ((r.upper < l.lower) || (l.upper < r.lower)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /// Return true if timeslices are at the same time and regions intersect
+  static constexpr bool intersects(const Box& lhs, const Box& rhs)
+  {
+    return lhs.time == rhs.time &&
+           homox::Comparisons<T, D>::intersects(lhs.region, rhs.region);
+  }
+
+  /// Return true if a rect may contain a point, used for exact searches
+  static constexpr bool intersects(const Rect<T, D>&  lhs,
+                                   const Point<T, D>& rhs)
+  {
+    for (size_t d = 0U; d < D; ++d) {
+      if (!within(lhs[d].position, rhs[d].position) ||
+          !within(lhs[d].velocity, rhs[d].velocity)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  static constexpr bool within(const DimRange<T>& range, const T value)
+  {
+    return range.lower <= value && value <= range.upper;
+  }
+};
+
+} // namespace spaix::tpr
+
+#endif // SPAIX_TPR_COMPARISONS_HPP
@@ -0,0 +1,165 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_TPR_OPERATIONS_HPP
+#define SPAIX_TPR_OPERATIONS_HPP
+
+#include <spaix/tpr/Point.hpp>
+#include <spaix/tpr/Rect.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <ratio>
+#include <utility>
+
+namespace spaix::tpr {
+
+/**
+   Operations used to measure and manipulate time-parameterised geometry.
+
+   This implements all of the operations required by any of the insertion and
+   split algorithms.  Volume is integrated over the time from zero to
+   `Horizon`, so insertion and splitting keep rectangles small over the period
+   that is expected to be queried, not only at time zero.
+
+   @tparam T Scalar type for positions, velocities, and times.
+   @tparam D Number of spatial dimensions.
+   @tparam Horizon Time horizon as a std::ratio.
+*/
+template<class T, size_t D, class Horizon = std::ratio<1>>
+struct Operations {
+  static_assert(D > 0, "at least one dimension is required");
+
+  /// The union of several data keys
+  using Box = Rect<T, D>;
+
+  /// A number that measures volume (a product of all dimensions and time)
+  using Volume = decltype(std::declval<T>() * std::declval<T>());
+
+  /// Return the time horizon that volumes are integrated over
+  static constexpr T horizon()
+  {
+    return static_cast<T>(Horizon::num) / static_cast<T>(Horizon::den);
+  }
+
+  /// Return the lower bound of a point in a dimension at time zero
+  template<size_t dim>
+  static constexpr T lower(const Point<T, D>& point)
+  {
+    return get<dim>(point).position;
+  }
+
+  /// Return the upper bound of a point in a dimension at time zero
+  template<size_t dim>
+  static constexpr T upper(const Point<T, D>& point)
+  {
+    return get<dim>(point).position;
+  }
+
+  /// Return the lower bound of a rect in a dimension at time zero
+  template<size_t dim>
+  static constexpr T lower(const Rect<T, D>& rect)
+  {
+    return get<dim>(rect).position.lower;
+  }
+
+  /// Return the upper bound of a rect in a dimension at time zero
+  template<size_t dim>
+  static constexpr T upper(const Rect<T, D>& rect)
+  {
+    return get<dim>(rect).position.upper;
+  }
+
+  /// Return the volume of a point (always zero)
+  static constexpr Volume volume(const Point<T, D>&) { return {}; }
+
+  /**
+     Return the volume of a rect integrated over the time horizon.
+
+     The extent in each dimension grows linearly with time, so the volume at
+     a time is a polynomial of degree `D`, which is integrated exactly.
+  */
+  static constexpr Volume volume(const Rect<T, D>& rect)
+  {
+    // Coefficients of the volume polynomial, lowest degree first
+    std::array<Volume, D + 1U> poly{};
+    poly[0] = Volume{1};
+
+    for (size_t d = 0U; d < D; ++d) {
+      const auto& r = rect[d];
+      if (r.position.upper < r.position.lower ||
+          r.velocity.upper < r.velocity.lower) {
+        return {};
+      }
+
+      // Multiply by (width + (spread * t))
+      const Volume width{r.position.upper - r.position.lower};
+      const Volume spread{r.velocity.upper - r.velocity.lower};
+      for (size_t k = d + 1U; k > 0U; --k) {
+        poly[k] = (poly[k] * width) + (poly[k - 1U] * spread);
+      }
+      poly[0] *= width;
+    }
+
+    // Integrate from zero to the horizon
+    Volume result{};
+    Volume power{horizon()};
+    for (size_t k = 0U; k <= D; ++k) {
+      result += poly[k] * power / static_cast<Volume>(k + 1U);
+      power *= horizon();
+    }
+
+    return result;
+  }
+
+  /// Return the union of a rect and a point
+  static constexpr Rect<T, D> unify(const Rect<T, D>&  lhs,
+                                    const Point<T, D>& rhs)
+  {
+    Rect<T, D> result{lhs};
+    expand(result, rhs);
+    return result;
+  }
+
+  /// Return the union of a rect and a rect
+  static constexpr Rect<T, D> unify(const Rect<T, D>& lhs,
+                                    const Rect<T, D>& rhs)
+  {
+    Rect<T, D> result{lhs};
+    expand(result, rhs);
+    return result;
+  }
+
+  /// Expand a rect to include a point
+  static constexpr void expand(Rect<T, D>& parent, const Point<T, D>& child)
+  {
+    for (size_t d = 0; d < D; ++d) {
+      expand_range(parent[d].position, child[d].position, child[d].position);
+      expand_range(parent[d].velocity, child[d].velocity, child[d].velocity);
+    }
+  }
+
+  /// Expand a rect to include another
+  static constexpr void expand(Rect<T, D>& parent, const Rect<T, D>& child)
+  {
+    for (size_t d = 0; d < D; ++d) {
+      const auto& c = child[d];
+      expand_range(parent[d].position, c.position.lower, c.position.upper);
+      expand_range(parent[d].velocity, c.velocity.lower, c.velocity.upper);
+    }
+  }
+
+private:
+  static constexpr void expand_range(DimRange<T>& range,
+                                     const T      lower,
+                                     const T      upper)
+  {
+    range.lower = std::min(range.lower, lower);
+    range.upper = std::max(range.upper, upper);
+  }
+};
+
+} // namespace spaix::tpr
+
+#endif // SPAIX_TPR_OPERATIONS_HPP
@@ -0,0 +1,116 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_TPR_POINT_HPP
+#define SPAIX_TPR_POINT_HPP
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace spaix::tpr {
+
+/// Linear motion in a dimension: a position at time zero and a velocity
+template<class T>
+struct Motion {
+  /// Return the position at the given time
+  [[nodiscard]] constexpr T at(const T time) const
+  {
+    return position + (velocity * time);
+  }
+
+  T position; ///< Position at time zero
+  T velocity; ///< Change in position per unit of time
+};
+
+template<class T>
+constexpr bool
+operator==(const Motion<T>& lhs, const Motion<T>& rhs)
+{
+  return lhs.position == rhs.position && lhs.velocity == rhs.velocity;
+}
+
+template<class T>
+constexpr bool
+operator!=(const Motion<T>& lhs, const Motion<T>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+/**
+   A time-parameterised point that moves linearly.
+
+   Positions are relative to a shared reference time of zero, so a point can
+   be indexed once and found at any later time without being updated until
+   its velocity changes.
+*/
+template<class T, size_t D>
+class Point
+{
+public:
+  using Array = std::array<Motion<T>, D>;
+
+  /// Construct a point from the motion in each dimension
+  template<class... Rest>
+  explicit constexpr Point(Motion<T> motion, Rest&&... motions)
+    : _motions{{motion, std::forward<Rest>(motions)...}}
+  {}
+
+  /// Construct a point from the motion in each dimension
+  explicit constexpr Point(Array motions)
+    : _motions{std::move(motions)}
+  {}
+
+  /// Return a point with the given motions observed at some `time`
+  [[nodiscard]] static constexpr Point observed(const T time, Array motions)
+  {
+    for (auto& motion : motions) {
+      motion.position -= motion.velocity * time;
+    }
+
+    return Point{motions};
+  }
+
+  [[nodiscard]] static constexpr size_t size() { return D; }
+
+  [[nodiscard]] constexpr const Array& array() const { return _motions; }
+
+  [[nodiscard]] constexpr const Motion<T>& operator[](const size_t i) const
+  {
+    return _motions[i];
+  }
+
+private:
+  Array _motions;
+};
+
+template<class T, size_t D>
+constexpr bool
+operator==(const Point<T, D>& lhs, const Point<T, D>& rhs)
+{
+  for (size_t i = 0U; i < D; ++i) {
+    if (lhs[i] != rhs[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template<class T, size_t D>
+constexpr bool
+operator!=(const Point<T, D>& lhs, const Point<T, D>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template<size_t dim, class T, size_t D>
+constexpr const Motion<T>&
+get(const Point<T, D>& point)
+{
+  return point[dim];
+}
+
+} // namespace spaix::tpr
+
+#endif // SPAIX_TPR_POINT_HPP
@@ -0,0 +1,131 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_TPR_RECT_HPP
+#define SPAIX_TPR_RECT_HPP
+
+#include <spaix/tpr/Point.hpp>
+#include <spaix/types.hpp>
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+namespace spaix::tpr {
+
+/**
+   Time-parameterised bounds in a dimension.
+
+   The lower bound starts at the lowest position and moves with the lowest
+   velocity, and likewise for the upper bound, so the range contains every
+   motion it was built from at any time from zero onwards.
+*/
+template<class T>
+struct MotionRange {
+  /// Return the range of positions at the given (non-negative) time
+  [[nodiscard]] constexpr DimRange<T> at(const T time) const
+  {
+    return {position.lower + (velocity.lower * time),
+            position.upper + (velocity.upper * time)};
+  }
+
+  DimRange<T> position; ///< Range of positions at time zero
+  DimRange<T> velocity; ///< Range of velocities
+};
+
+template<class T>
+constexpr bool
+operator==(const MotionRange<T>& lhs, const MotionRange<T>& rhs)
+{
+  return lhs.position == rhs.position && lhs.velocity == rhs.velocity;
+}
+
+/// A multi-dimensional time-parameterised rectangle
+template<class T, size_t D>
+class Rect
+{
+public:
+  using Array = std::array<MotionRange<T>, D>;
+
+  /// Construct an empty rectangle
+  explicit constexpr Rect()
+    : _ranges{}
+  {
+    for (size_t i = 0; i < D; ++i) {
+      _ranges[i] = {DimRange<T>{std::numeric_limits<T>::max(),
+                                std::numeric_limits<T>::lowest()},
+                    DimRange<T>{std::numeric_limits<T>::max(),
+                                std::numeric_limits<T>::lowest()}};
+    }
+  }
+
+  /// Construct a rectangle from a single point
+  explicit constexpr Rect(const Point<T, D>& point)
+    : _ranges{}
+  {
+    for (size_t i = 0; i < D; ++i) {
+      _ranges[i] = {DimRange<T>{point[i].position, point[i].position},
+                    DimRange<T>{point[i].velocity, point[i].velocity}};
+    }
+  }
+
+  /// Construct a rectangle for the given ranges in each dimension
+  template<class... Rest>
+  explicit constexpr Rect(MotionRange<T> r, Rest&&... ranges)
+    : _ranges{{r, std::forward<Rest>(ranges)...}}
+  {}
+
+  /// Construct a rectangle for the given ranges in each dimension
+  explicit constexpr Rect(Array ranges)
+    : _ranges{std::move(ranges)}
+  {}
+
+  [[nodiscard]] static constexpr size_t size() { return D; }
+
+  [[nodiscard]] constexpr const Array& array() const { return _ranges; }
+
+  [[nodiscard]] constexpr const MotionRange<T>& operator[](const size_t i) const
+  {
+    return _ranges[i];
+  }
+
+  [[nodiscard]] constexpr MotionRange<T>& operator[](const size_t i)
+  {
+    return _ranges[i];
+  }
+
+private:
+  Array _ranges;
+};
+
+template<class T, size_t D>
+constexpr bool
+operator==(const Rect<T, D>& lhs, const Rect<T, D>& rhs)
+{
+  for (size_t i = 0U; i < D; ++i) {
+    if (!(lhs[i] == rhs[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template<class T, size_t D>
+constexpr bool
+operator!=(const Rect<T, D>& lhs, const Rect<T, D>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template<size_t dim, class T, size_t D>
+constexpr const MotionRange<T>&
+get(const Rect<T, D>& rect)
+{
+  return rect.array()[dim];
+}
+
+} // namespace spaix::tpr
+
+#endif // SPAIX_TPR_RECT_HPP
@@ -0,0 +1,27 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SPAIX_TPR_TIMESLICE_HPP
+#define SPAIX_TPR_TIMESLICE_HPP
+
+#include <spaix/homox/Rect.hpp>
+
+#include <cstddef>
+
+namespace spaix::tpr {
+
+/**
+   A static region at a single point in time.
+
+   This is the query key for time-parameterised trees, which finds the items
+   that are (or will be) in a region at some time from zero onwards.
+*/
+template<class T, size_t D>
+struct Timeslice {
+  T                 time;   ///< Time of the query, relative to time zero
+  homox::Rect<T, D> region; ///< Region of space at that time
+};
+
+} // namespace spaix::tpr
+
+#endif // SPAIX_TPR_TIMESLICE_HPP
@@ -0,0 +1,189 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <spaix_test/Distribution.hpp>
+#include <spaix_test/options.hpp>
+#include <spaix_test/write_row.hpp>
+
+#include <spaix/Config.hpp>
+#include <spaix/DataPlacement.hpp>
+#include <spaix/LinearInsertion.hpp>
+#include <spaix/LinearSplit.hpp>
+#include <spaix/Queries.hpp>
+#include <spaix/RTree.hpp>
+#include <spaix/budget/Nodes.hpp>
+#include <spaix/heterox/Comparisons.hpp>
+#include <spaix/heterox/Operations.hpp>
+#include <spaix/heterox/Point.hpp>
+#include <spaix/heterox/Rect.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Args        = spaix::test::Arguments;
+using Scalar      = float;
+using Data        = size_t;
+using Rect2       = spaix::heterox::Rect<Scalar, Scalar>;
+using Point2      = spaix::heterox::Point<Scalar, Scalar>;
+using Comparisons = spaix::heterox::Comparisons<Scalar, Scalar>;
+using Ops         = spaix::heterox::Operations<Scalar, Scalar>;
+using Queries     = spaix::Queries<Comparisons>;
+
+template<class T>
+using Distribution = spaix::test::Distribution<T>;
+
+using Tree = spaix::RTree<
+  Rect2,
+  Point2,
+  Data,
+  spaix::Config<spaix::StaticStructure<16U, 16U, spaix::DataPlacement::inlined>,
+                spaix::LinearSplit<Ops, 2U>,
+                spaix::LinearInsertion<Ops>>>;
+
+/// Query windows clustered around a few hot spots
+class Workload
+{
+public:
+  Workload(const Args& args, std::mt19937& rng)
+    : _spread{0.0f, std::stof(args.at("span")) / 50.0f}
+    , _size{std::stof(args.at("span")) / 200.0f}
+  {
+    const auto n_centres = std::stoul(args.at("centres"));
+    const auto span      = std::stof(args.at("span"));
+
+    std::uniform_real_distribution<Scalar> position{0.0f, span};
+    for (size_t i = 0U; i < n_centres; ++i) {
+      _centres.push_back({position(rng), position(rng)});
+    }
+  }
+
+  Rect2 operator()(std::mt19937& rng)
+  {
+    const auto& centre = _centres[rng() % _centres.size()];
+    const auto  x      = centre.first + _spread(rng);
+    const auto  y      = centre.second + _spread(rng);
+
+    return Rect2{{x, x + _size}, {y, y + _size}};
+  }
+
+private:
+  std::vector<std::pair<Scalar, Scalar>> _centres;
+  std::normal_distribution<Scalar>       _spread;
+  Scalar                                 _size;
+};
+
+struct Result {
+  double nodes_per_query;
+  double t_query;
+  size_t n_matches;
+};
+
+/// Run queries and measure the nodes visited by each
+Result
+measure(const Tree& tree, Workload& workload, const size_t n_queries)
+{
+  using Seconds = std::chrono::duration<double>;
+
+  std::mt19937         rng{1U}; // Same queries every time
+  Distribution<double> query_times;
+  size_t               n_nodes   = 0U;
+  size_t               n_matches = 0U;
+  for (size_t q = 0U; q < n_queries; ++q) {
+    const auto window    = workload(rng);
+    const auto predicate = Queries::within(window);
+
+    const auto t_start = std::chrono::steady_clock::now();
+    tree.visit_matches(predicate, [&n_matches](const auto&) { ++n_matches; });
+    const auto t_end = std::chrono::steady_clock::now();
+    query_times.update(Seconds(t_end - t_start).count());
+
+    spaix::budget::Nodes budget{SIZE_MAX};
+    Tree::Progress       progress;
+    tree.visit_matches(predicate, [](const auto&) {}, budget, progress);
+    n_nodes += SIZE_MAX - budget.remaining();
+  }
+
+  return {static_cast<double>(n_nodes) / static_cast<double>(n_queries),
+          query_times.mean(),
+          n_matches};
+}
+
+int
+run(const Args& args, std::ostream& os)
+{
+  const auto n_elements  = std::stoul(args.at("size"));
+  const auto n_queries   = std::stoul(args.at("queries"));
+  const auto n_rounds    = std::stoul(args.at("rounds"));
+  const auto max_overlap = std::stod(args.at("overlap"));
+  const auto span        = std::stof(args.at("span"));
+  const auto seed        = static_cast<uint32_t>(std::stoul(args.at("seed")));
+
+  std::mt19937                           rng{seed};
+  std::uniform_real_distribution<Scalar> position{0.0f, span};
+  Workload                               workload{args, rng};
+
+  Tree tree;
+  for (size_t i = 0U; i < n_elements; ++i) {
+    tree.insert(Point2{position(rng), position(rng)}, i);
+  }
+
+  spaix::test::write_row(
+    os, "round", "n_changed", "nodes_per_query", "t_query");
+
+  const auto initial = measure(tree, workload, n_queries);
+  spaix::test::write_row(
+    os, 0U, 0U, initial.nodes_per_query, initial.t_query);
+
+  // Record a round of the workload, adapt to it, then measure again
+  for (size_t r = 1U; r <= n_rounds; ++r) {
+    tree.record_visits(true);
+    for (size_t q = 0U; q < n_queries; ++q) {
+      tree.visit_matches(Queries::within(workload(rng)), [](const auto&) {});
+    }
+
+    tree.record_visits(false);
+    const auto n_changed = tree.adapt(max_overlap);
+    const auto result    = measure(tree, workload, n_queries);
+    if (result.n_matches != initial.n_matches) {
+      throw std::runtime_error("Adapted query results don't match");
+    }
+
+    spaix::test::write_row(
+      os, r, n_changed, result.nodes_per_query, result.t_query);
+  }
+
+  return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  const spaix::test::Options opts{
+    {"centres", {"Number of query hot spots", "COUNT", "4"}},
+    {"overlap", {"Maximum overlap of hot directories", "NUMBER", "0.1"}},
+    {"queries", {"Number of queries per round", "COUNT", "10000"}},
+    {"rounds", {"Number of adaptation rounds", "COUNT", "4"}},
+    {"seed", {"Random number generator seed", "SEED", "5489"}},
+    {"size", {"Number of items", "ELEMENTS", "100000"}},
+    {"span", {"Dimension span", "NUMBER", "10000"}},
+  };
+
+  try {
+    const auto args = parse_options(opts, argc, argv);
+    return run(args, std::cout);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "error: " << e.what() << "\n\n";
+    print_usage(argv[0], opts);
+    return 1;
+  }
+}
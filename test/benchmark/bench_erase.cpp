@@ -0,0 +1,164 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <spaix_test/Distribution.hpp>
+#include <spaix_test/options.hpp>
+#include <spaix_test/write_row.hpp>
+
+#include <spaix/Config.hpp>
+#include <spaix/DataPlacement.hpp>
+#include <spaix/HandleTable.hpp>
+#include <spaix/LinearInsertion.hpp>
+#include <spaix/MergeUnderflow.hpp>
+#include <spaix/NullSummary.hpp>
+#include <spaix/QuadraticSplit.hpp>
+#include <spaix/Queries.hpp>
+#include <spaix/RTree.hpp>
+#include <spaix/ReinsertUnderflow.hpp>
+#include <spaix/heterox/Comparisons.hpp>
+#include <spaix/heterox/Operations.hpp>
+#include <spaix/heterox/Point.hpp>
+#include <spaix/heterox/Rect.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Args        = spaix::test::Arguments;
+using Scalar      = float;
+using Data        = size_t;
+using Rect2       = spaix::heterox::Rect<Scalar, Scalar>;
+using Point2      = spaix::heterox::Point<Scalar, Scalar>;
+using Comparisons = spaix::heterox::Comparisons<Scalar, Scalar>;
+using Ops         = spaix::heterox::Operations<Scalar, Scalar>;
+using Queries     = spaix::Queries<Comparisons>;
+
+template<class T>
+using Distribution = spaix::test::Distribution<T>;
+
+template<class Underflow>
+using Tree = spaix::RTree<
+  Rect2,
+  Point2,
+  Data,
+  spaix::Config<spaix::StaticStructure<16U, 16U, spaix::DataPlacement::inlined>,
+                spaix::QuadraticSplit<Ops>,
+                spaix::LinearInsertion<Ops>,
+                spaix::DefaultMinFillRatio,
+                spaix::HandleTable<Data>,
+                spaix::NullSummary,
+                Underflow>>;
+
+struct Result {
+  double erases_per_s;
+  double t_query;
+  size_t n_matches;
+};
+
+template<class Underflow>
+Result
+run_policy(const Args& args)
+{
+  using Seconds = std::chrono::duration<double>;
+
+  const auto n_elements = std::stoul(args.at("size"));
+  const auto n_queries  = std::stoul(args.at("queries"));
+  const auto fraction   = std::stof(args.at("erase"));
+  const auto span       = std::stof(args.at("span"));
+  const auto seed       = static_cast<uint32_t>(std::stoul(args.at("seed")));
+
+  // Use the same items, erasures, and queries for every policy
+  std::mt19937                           rng{seed};
+  std::uniform_real_distribution<Scalar> position{0.0f, span};
+
+  Tree<Underflow> tree;
+  for (size_t i = 0U; i < n_elements; ++i) {
+    tree.insert(Point2{position(rng), position(rng)}, i);
+  }
+
+  std::vector<Data> order(n_elements);
+  std::iota(order.begin(), order.end(), Data{0U});
+  std::shuffle(order.begin(), order.end(), rng);
+  order.resize(static_cast<size_t>(static_cast<float>(n_elements) * fraction));
+
+  // Erase a random subset of items by ID
+  const auto t_erase_start = std::chrono::steady_clock::now();
+  for (const auto id : order) {
+    auto i = tree.locate(*tree.observer().find(id));
+    tree.erase(i);
+  }
+  const auto t_erase_end = std::chrono::steady_clock::now();
+
+  // Run some small window queries on what remains
+  Distribution<double> query_times;
+  size_t               n_matches = 0U;
+  for (size_t q = 0U; q < n_queries; ++q) {
+    const auto x0     = position(rng);
+    const auto y0     = position(rng);
+    const auto window = Rect2{{x0, x0 + (span / 100.0f)},
+                              {y0, y0 + (span / 100.0f)}};
+
+    const auto t_query_start = std::chrono::steady_clock::now();
+    tree.visit_matches(Queries::within(window),
+                       [&n_matches](const auto&) { ++n_matches; });
+    const auto t_query_end = std::chrono::steady_clock::now();
+
+    query_times.update(Seconds(t_query_end - t_query_start).count());
+  }
+
+  const auto t_erase = Seconds(t_erase_end - t_erase_start).count();
+  return {static_cast<double>(order.size()) / t_erase,
+          query_times.mean(),
+          n_matches};
+}
+
+int
+run(const Args& args, std::ostream& os)
+{
+  spaix::test::write_row(os, "underflow", "erases_per_s", "t_query");
+
+  const auto reinsert = run_policy<spaix::ReinsertUnderflow>(args);
+  spaix::test::write_row(
+    os, "reinsert", reinsert.erases_per_s, reinsert.t_query);
+
+  const auto merge = run_policy<spaix::MergeUnderflow<Ops>>(args);
+  if (merge.n_matches != reinsert.n_matches) {
+    throw std::runtime_error("Query results don't match");
+  }
+
+  spaix::test::write_row(os, "merge", merge.erases_per_s, merge.t_query);
+
+  return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  const spaix::test::Options opts{
+    {"erase", {"Fraction of items to erase", "NUMBER", "0.75"}},
+    {"queries", {"Number of window queries", "COUNT", "1000"}},
+    {"seed", {"Random number generator seed", "SEED", "5489"}},
+    {"size", {"Number of items", "ELEMENTS", "100000"}},
+    {"span", {"Dimension span", "NUMBER", "10000"}},
+  };
+
+  try {
+    const auto args = parse_options(opts, argc, argv);
+    return run(args, std::cout);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "error: " << e.what() << "\n\n";
+    print_usage(argv[0], opts);
+    return 1;
+  }
+}
@@ -0,0 +1,210 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <spaix_test/Distribution.hpp>
+#include <spaix_test/options.hpp>
+#include <spaix_test/write_row.hpp>
+
+#include <spaix/Config.hpp>
+#include <spaix/DataPlacement.hpp>
+#include <spaix/LinearInsertion.hpp>
+#include <spaix/QuadraticSplit.hpp>
+#include <spaix/RTree.hpp>
+#include <spaix/heterox/Comparisons.hpp>
+#include <spaix/heterox/Operations.hpp>
+#include <spaix/heterox/Point.hpp>
+#include <spaix/heterox/Rect.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Args        = spaix::test::Arguments;
+using Scalar      = float;
+using Data        = size_t;
+using Rect2       = spaix::heterox::Rect<Scalar, Scalar>;
+using Point2      = spaix::heterox::Point<Scalar, Scalar>;
+using Comparisons = spaix::heterox::Comparisons<Scalar, Scalar>;
+using Ops         = spaix::heterox::Operations<Scalar, Scalar>;
+
+template<class T>
+using Distribution = spaix::test::Distribution<T>;
+
+using Tree = spaix::RTree<
+  Rect2,
+  Point2,
+  Data,
+  spaix::Config<spaix::StaticStructure<16U, 16U, spaix::DataPlacement::inlined>,
+                spaix::QuadraticSplit<Ops>,
+                spaix::LinearInsertion<Ops>>>;
+
+/// Return the cell in a dimension that contains a coordinate
+size_t
+cell_index(const Scalar value,
+           const Scalar lower,
+           const Scalar upper,
+           const size_t cells_per_dim)
+{
+  const auto offset = static_cast<double>(value - lower);
+  const auto span   = static_cast<double>(upper - lower);
+
+  return std::min(
+    static_cast<size_t>(offset / span * static_cast<double>(cells_per_dim)),
+    cells_per_dim - 1U);
+}
+
+/// A query for the items whose lower corner is within one grid cell
+struct CellQuery {
+  template<class DirKey>
+  [[nodiscard]] bool directory(const DirKey& k) const
+  {
+    return Comparisons::intersects(window, k) &&
+           covers(x, Ops::lower<0>(k), Ops::upper<0>(k), cell_x) &&
+           covers(y, Ops::lower<1>(k), Ops::upper<1>(k), cell_y);
+  }
+
+  template<class DatKey>
+  [[nodiscard]] bool leaf(const DatKey& k) const
+  {
+    const auto kx = Ops::lower<0>(k);
+    const auto ky = Ops::lower<1>(k);
+
+    return Comparisons::contains(window, Point2{kx, ky}) &&
+           cell_index(kx, x.lower, x.upper, cells_per_dim) == cell_x &&
+           cell_index(ky, y.lower, y.upper, cells_per_dim) == cell_y;
+  }
+
+  /// Return true iff a range in the window may have a corner in a cell
+  [[nodiscard]] bool covers(const spaix::DimRange<Scalar>& range,
+                            const Scalar                   lower,
+                            const Scalar                   upper,
+                            const size_t                   cell) const
+  {
+    const auto first = std::max(lower, range.lower);
+    const auto last  = std::min(upper, range.upper);
+
+    return cell_index(first, range.lower, range.upper, cells_per_dim) <=
+             cell &&
+           cell <= cell_index(last, range.lower, range.upper, cells_per_dim);
+  }
+
+  Rect2                   window;
+  spaix::DimRange<Scalar> x;
+  spaix::DimRange<Scalar> y;
+  size_t                  cells_per_dim;
+  size_t                  cell_x;
+  size_t                  cell_y;
+};
+
+/// Count items in every cell with one query per cell
+std::vector<size_t>
+query_cells(const Tree& tree, const Rect2& window, const size_t cells_per_dim)
+{
+  const auto x =
+    spaix::make_dim_range(Ops::lower<0>(window), Ops::upper<0>(window));
+  const auto y =
+    spaix::make_dim_range(Ops::lower<1>(window), Ops::upper<1>(window));
+
+  std::vector<size_t> counts(cells_per_dim * cells_per_dim);
+  for (size_t cy = 0U; cy < cells_per_dim; ++cy) {
+    for (size_t cx = 0U; cx < cells_per_dim; ++cx) {
+      auto& count = counts[(cy * cells_per_dim) + cx];
+      tree.visit_matches(CellQuery{window, x, y, cells_per_dim, cx, cy},
+                         [&count](const auto&) { ++count; });
+    }
+  }
+
+  return counts;
+}
+
+int
+run(const Args& args, std::ostream& os)
+{
+  using Seconds = std::chrono::duration<double>;
+
+  const auto n_elements = std::stoul(args.at("size"));
+  const auto n_queries  = std::stoul(args.at("queries"));
+  const auto span       = std::stof(args.at("span"));
+  const auto max_cells  = std::stoul(args.at("cells"));
+  const auto seed       = static_cast<uint32_t>(std::stoul(args.at("seed")));
+
+  std::mt19937                           rng{seed};
+  std::uniform_real_distribution<Scalar> dist{0.0f, span};
+
+  Tree tree;
+  for (size_t i = 0U; i < n_elements; ++i) {
+    tree.insert(Point2{floorf(dist(rng)), floorf(dist(rng))}, i);
+  }
+
+  spaix::test::write_row(os, "n", "cells", "t_histogram", "t_cells", "speedup");
+
+  for (size_t cells = 1U; cells <= max_cells; cells *= 2U) {
+    Distribution<double> histogram_times;
+    Distribution<double> cells_times;
+
+    for (size_t q = 0U; q < n_queries; ++q) {
+      const auto x0     = dist(rng) / 2.0f;
+      const auto y0     = dist(rng) / 2.0f;
+      const auto window = Rect2{{x0, x0 + (span / 2.0f)},
+                                {y0, y0 + (span / 2.0f)}};
+
+      const auto t_histogram_start = std::chrono::steady_clock::now();
+      const auto histogram         = tree.histogram(window, cells);
+      const auto t_histogram_end   = std::chrono::steady_clock::now();
+
+      const auto t_cells_start = std::chrono::steady_clock::now();
+      const auto cell_counts   = query_cells(tree, window, cells);
+      const auto t_cells_end   = std::chrono::steady_clock::now();
+
+      if (histogram != cell_counts) {
+        throw std::runtime_error("Histogram doesn't match cell queries");
+      }
+
+      histogram_times.update(
+        Seconds(t_histogram_end - t_histogram_start).count());
+      cells_times.update(Seconds(t_cells_end - t_cells_start).count());
+    }
+
+    spaix::test::write_row(os,
+                           tree.size(),
+                           cells,
+                           histogram_times.mean(),
+                           cells_times.mean(),
+                           cells_times.mean() / histogram_times.mean());
+  }
+
+  return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  const spaix::test::Options opts{
+    {"cells", {"Maximum number of cells per dimension", "COUNT", "64"}},
+    {"queries", {"Number of windows per grid size", "COUNT", "10"}},
+    {"seed", {"Random number generator seed", "SEED", "5489"}},
+    {"size", {"Number of elements", "ELEMENTS", "100000"}},
+    {"span", {"Dimension span", "NUMBER", "10000"}},
+  };
+
+  try {
+    const auto args = parse_options(opts, argc, argv);
+    return run(args, std::cout);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "error: " << e.what() << "\n\n";
+    print_usage(argv[0], opts);
+    return 1;
+  }
+}
@@ -0,0 +1,208 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <spaix_test/Distribution.hpp>
+#include <spaix_test/options.hpp>
+#include <spaix_test/write_row.hpp>
+
+#include <spaix/Config.hpp>
+#include <spaix/DataPlacement.hpp>
+#include <spaix/HandleTable.hpp>
+#include <spaix/LinearInsertion.hpp>
+#include <spaix/QuadraticSplit.hpp>
+#include <spaix/Queries.hpp>
+#include <spaix/RTree.hpp>
+#include <spaix/heterox/Comparisons.hpp>
+#include <spaix/heterox/Operations.hpp>
+#include <spaix/heterox/Point.hpp>
+#include <spaix/heterox/Rect.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Args        = spaix::test::Arguments;
+using Scalar      = float;
+using Data        = size_t;
+using Rect2       = spaix::heterox::Rect<Scalar, Scalar>;
+using Point2      = spaix::heterox::Point<Scalar, Scalar>;
+using Comparisons = spaix::heterox::Comparisons<Scalar, Scalar>;
+using Ops         = spaix::heterox::Operations<Scalar, Scalar>;
+using Queries     = spaix::Queries<Comparisons>;
+
+template<class T>
+using Distribution = spaix::test::Distribution<T>;
+
+using Tree = spaix::RTree<
+  Rect2,
+  Point2,
+  Data,
+  spaix::Config<spaix::StaticStructure<16U, 16U, spaix::DataPlacement::inlined>,
+                spaix::QuadraticSplit<Ops>,
+                spaix::LinearInsertion<Ops>,
+                spaix::DefaultMinFillRatio,
+                spaix::HandleTable<Data>>>;
+
+/// A moving object with a constant velocity that bounces off the edges
+struct Object {
+  Scalar x;
+  Scalar y;
+  Scalar dx;
+  Scalar dy;
+};
+
+/// Return the loose bounds of a point enlarged by `slack` in every direction
+Rect2
+around(const Scalar x, const Scalar y, const Scalar slack)
+{
+  return Rect2{{x - slack, x + slack}, {y - slack, y + slack}};
+}
+
+/// Move a coordinate one step, reflecting the velocity at the edges
+void
+advance(Scalar& value, Scalar& velocity, const Scalar span)
+{
+  value += velocity;
+  if (value < 0.0f || value > span) {
+    velocity = -velocity;
+    value += 2.0f * velocity;
+  }
+}
+
+struct Result {
+  double relocations_per_s;
+  double t_query;
+  size_t n_matches;
+};
+
+Result
+run_slack(const Args& args, const Scalar slack)
+{
+  using Seconds = std::chrono::duration<double>;
+
+  const auto n_elements = std::stoul(args.at("size"));
+  const auto n_steps    = std::stoul(args.at("steps"));
+  const auto n_queries  = std::stoul(args.at("queries"));
+  const auto span       = std::stof(args.at("span"));
+  const auto speed      = std::stof(args.at("speed"));
+  const auto seed       = static_cast<uint32_t>(std::stoul(args.at("seed")));
+
+  // Use the same objects and queries for every slack to compare results
+  std::mt19937                           rng{seed};
+  std::uniform_real_distribution<Scalar> position{0.0f, span};
+  std::uniform_real_distribution<Scalar> velocity{-speed, speed};
+
+  std::vector<Object> objects;
+  Tree                tree;
+  for (size_t i = 0U; i < n_elements; ++i) {
+    const Object o{position(rng), position(rng), velocity(rng), velocity(rng)};
+    objects.emplace_back(o);
+    if (slack > 0.0f) {
+      tree.insert(Point2{o.x, o.y}, i, around(o.x, o.y, slack));
+    } else {
+      tree.insert(Point2{o.x, o.y}, i);
+    }
+  }
+
+  Distribution<double> query_times;
+  size_t               n_matches     = 0U;
+  double               t_relocations = 0.0;
+  for (size_t s = 0U; s < n_steps; ++s) {
+    // Move every object one step
+    const auto t_move_start = std::chrono::steady_clock::now();
+    for (size_t i = 0U; i < n_elements; ++i) {
+      auto& o = objects[i];
+      advance(o.x, o.dx, span);
+      advance(o.y, o.dy, span);
+
+      const auto& handle = *tree.observer().find(i);
+      if (slack > 0.0f) {
+        tree.relocate(handle, Point2{o.x, o.y}, around(o.x, o.y, slack));
+      } else {
+        tree.relocate(handle, Point2{o.x, o.y});
+      }
+    }
+    const auto t_move_end = std::chrono::steady_clock::now();
+    t_relocations += Seconds(t_move_end - t_move_start).count();
+
+    // Run some small window queries
+    for (size_t q = 0U; q < n_queries; ++q) {
+      const auto x0     = position(rng);
+      const auto y0     = position(rng);
+      const auto window = Rect2{{x0, x0 + (span / 100.0f)},
+                                {y0, y0 + (span / 100.0f)}};
+
+      const auto t_query_start = std::chrono::steady_clock::now();
+      tree.visit_matches(Queries::within(window),
+                         [&n_matches](const auto&) { ++n_matches; });
+      const auto t_query_end = std::chrono::steady_clock::now();
+
+      query_times.update(Seconds(t_query_end - t_query_start).count());
+    }
+  }
+
+  return {static_cast<double>(n_elements * n_steps) / t_relocations,
+          query_times.mean(),
+          n_matches};
+}
+
+int
+run(const Args& args, std::ostream& os)
+{
+  const auto speed     = std::stof(args.at("speed"));
+  const auto max_slack = std::stof(args.at("slack"));
+
+  spaix::test::write_row(
+    os, "slack", "relocations_per_s", "t_query", "query_overhead");
+
+  const auto tight = run_slack(args, 0.0f);
+  spaix::test::write_row(os, 0.0f, tight.relocations_per_s, tight.t_query, 1.0);
+
+  // Measure slack as a multiple of the maximum speed per step
+  for (auto factor = 0.5f; factor <= max_slack; factor *= 2.0f) {
+    const auto loose = run_slack(args, factor * speed);
+    if (loose.n_matches != tight.n_matches) {
+      throw std::runtime_error("Loose query results don't match");
+    }
+
+    spaix::test::write_row(os,
+                           factor * speed,
+                           loose.relocations_per_s,
+                           loose.t_query,
+                           loose.t_query / tight.t_query);
+  }
+
+  return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  const spaix::test::Options opts{
+    {"queries", {"Number of window queries per step", "COUNT", "100"}},
+    {"seed", {"Random number generator seed", "SEED", "5489"}},
+    {"size", {"Number of moving objects", "ELEMENTS", "100000"}},
+    {"slack", {"Maximum slack in steps of movement", "NUMBER", "16"}},
+    {"span", {"Dimension span", "NUMBER", "10000"}},
+    {"speed", {"Maximum speed per step", "NUMBER", "1"}},
+    {"steps", {"Number of movement steps", "COUNT", "10"}},
+  };
+
+  try {
+    const auto args = parse_options(opts, argc, argv);
+    return run(args, std::cout);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "error: " << e.what() << "\n\n";
+    print_usage(argv[0], opts);
+    return 1;
+  }
+}
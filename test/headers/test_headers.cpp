@@ -6,17 +6,30 @@
 #include <spaix/DataNode.hpp>                // IWYU pragma: keep
 #include <spaix/DataPlacement.hpp>           // IWYU pragma: keep
 #include <spaix/EntryIterator.hpp>           // IWYU pragma: keep
+#include <spaix/Generator.hpp>               // IWYU pragma: keep
+#include <spaix/HandleTable.hpp>             // IWYU pragma: keep
+#include <spaix/ItemHandle.hpp>              // IWYU pragma: keep
 #include <spaix/Iterator.hpp>                // IWYU pragma: keep
 #include <spaix/LinearInsertion.hpp>         // IWYU pragma: keep
 #include <spaix/LinearSplit.hpp>             // IWYU pragma: keep
+#include <spaix/MergeUnderflow.hpp>          // IWYU pragma: keep
+#include <spaix/NullObserver.hpp>            // IWYU pragma: keep
+#include <spaix/NullSummary.hpp>             // IWYU pragma: keep
 #include <spaix/QuadraticSplit.hpp>          // IWYU pragma: keep
 #include <spaix/Queries.hpp>                 // IWYU pragma: keep
+#include <spaix/QueryCache.hpp>              // IWYU pragma: keep
+#include <spaix/QueryCursor.hpp>             // IWYU pragma: keep
+#include <spaix/QueryProgress.hpp>           // IWYU pragma: keep
+#include <spaix/ReinsertUnderflow.hpp>       // IWYU pragma: keep
 #include <spaix/RTree.hpp>                   // IWYU pragma: keep
 #include <spaix/RTree.ipp>                   // IWYU pragma: keep
 #include <spaix/SideChooser.hpp>             // IWYU pragma: keep
 #include <spaix/SplitSeeds.hpp>              // IWYU pragma: keep
 #include <spaix/StaticVector.hpp>            // IWYU pragma: keep
+#include <spaix/Subscriptions.hpp>           // IWYU pragma: keep
 #include <spaix/TreeRange.hpp>               // IWYU pragma: keep
+#include <spaix/budget/Deadline.hpp>         // IWYU pragma: keep
+#include <spaix/budget/Nodes.hpp>            // IWYU pragma: keep
 #include <spaix/concepts.hpp>                // IWYU pragma: keep
 #include <spaix/detail/DatEntryType.hpp>     // IWYU pragma: keep
 #include <spaix/detail/DirectoryNode.hpp>    // IWYU pragma: keep
@@ -25,6 +38,7 @@
 #include <spaix/detail/attributes.hpp>       // IWYU pragma: keep
 #include <spaix/detail/distribute.hpp>       // IWYU pragma: keep
 #include <spaix/detail/entry.hpp>            // IWYU pragma: keep
+#include <spaix/detail/matches.hpp>          // IWYU pragma: keep
 #include <spaix/detail/power.hpp>            // IWYU pragma: keep
 #include <spaix/heterox/Comparisons.hpp>     // IWYU pragma: keep
 #include <spaix/heterox/Operations.hpp>      // IWYU pragma: keep
@@ -39,6 +53,11 @@
 #include <spaix/search/Exactly.hpp>          // IWYU pragma: keep
 #include <spaix/search/Touching.hpp>         // IWYU pragma: keep
 #include <spaix/search/Within.hpp>           // IWYU pragma: keep
+#include <spaix/tpr/Comparisons.hpp>         // IWYU pragma: keep
+#include <spaix/tpr/Operations.hpp>          // IWYU pragma: keep
+#include <spaix/tpr/Point.hpp>               // IWYU pragma: keep
+#include <spaix/tpr/Rect.hpp>                // IWYU pragma: keep
+#include <spaix/tpr/Timeslice.hpp>           // IWYU pragma: keep
 #include <spaix/types.hpp>                   // IWYU pragma: keep
 
 #ifdef __GNUC__
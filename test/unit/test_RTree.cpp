@@ -3,16 +3,28 @@
 
 #include <spaix/Config.hpp>
 #include <spaix/DataPlacement.hpp>
+#include <spaix/HandleTable.hpp>
 #include <spaix/LinearInsertion.hpp> // IWYU pragma: keep
 #include <spaix/LinearSplit.hpp>     // IWYU pragma: keep
+#include <spaix/MergeUnderflow.hpp>
+#include <spaix/NullObserver.hpp>
+#include <spaix/NullSummary.hpp>
 #include <spaix/QuadraticSplit.hpp>  // IWYU pragma: keep
 #include <spaix/Queries.hpp>
+#include <spaix/QueryCache.hpp>
 #include <spaix/RTree.hpp>
 #include <spaix/StaticVector.hpp>
+#include <spaix/Subscriptions.hpp>
+#include <spaix/budget/Deadline.hpp>
+#include <spaix/budget/Nodes.hpp>
 #include <spaix/heterox/Comparisons.hpp>
 #include <spaix/heterox/Operations.hpp>
 #include <spaix/heterox/Point.hpp>
 #include <spaix/heterox/Rect.hpp>
+#include <spaix/homox/Comparisons.hpp>
+#include <spaix/homox/Operations.hpp>
+#include <spaix/homox/Point.hpp>
+#include <spaix/homox/Rect.hpp>
 #include <spaix/types.hpp>
 
 #undef NDEBUG
@@ -21,6 +33,9 @@
 #include <spaix_test/options.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
 #include <exception>
 #include <iostream>
@@ -30,6 +45,7 @@
 #include <random>
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -64,6 +80,58 @@ make_key<Rect>(const unsigned x, const unsigned y)
               {static_cast<float>(y), static_cast<float>(y) + 1.0f}};
 }
 
+/// Return a data node from an element of a batch
+template<class DatNode>
+const DatNode&
+batch_node(const DatNode& node)
+{
+  return node;
+}
+
+/// Return a data node from an element of a batch of pointers
+template<class DatNode>
+const DatNode&
+batch_node(const DatNode* const node)
+{
+  return *node;
+}
+
+/// A visitor that accumulates the data it visits, for parallel queries
+struct SumVisitor {
+  template<class DatNode>
+  void operator()(const DatNode& node)
+  {
+    ++count;
+    sum += node.second;
+  }
+
+  size_t count{};
+  size_t sum{};
+};
+
+/// A search which counts how many directories it is checked against
+template<class Search>
+struct CountingSearch {
+  template<class DirKey>
+  [[nodiscard]] bool directory(const DirKey& k) const noexcept
+  {
+    ++*n_directories;
+    return search.directory(k);
+  }
+
+  template<class DatKey>
+  [[nodiscard]] bool leaf(const DatKey& k) const noexcept
+  {
+    return search.leaf(k);
+  }
+
+  Search  search;
+  size_t* n_directories;
+};
+
+template<class Search>
+CountingSearch(Search, size_t*) -> CountingSearch<Search>;
+
 template<class Tree>
 void
 test_empty_tree(const Tree& tree, const unsigned span)
@@ -328,12 +396,344 @@ test_queries(const Tree&    tree,
     tree.visit_matches(Queries::within(query), verify);
     CHECK((count == expected_count));
 
+    // Batched visitor query, with both whole and partially matching leaves
+    using BatchView = typename Tree::BatchView;
+
+    const auto visit_batch = [&](const BatchView& batch) {
+      CHECK(batch.size() > 0U);
+      for (const auto& element : batch) {
+        verify(batch_node(element));
+      }
+    };
+
+    count = 0;
+    tree.visit_matches_batched(Queries::within(query), visit_batch);
+    CHECK((count == expected_count));
+
+    count = 0;
+    tree.visit_matches_batched(
+      Queries::within(tree.bounds()),
+      [&](const BatchView& batch) { count += batch.size(); });
+    CHECK((count == tree.size()));
+
+    // Parallel query with per-thread sums merged at the end
+    SumVisitor expected_sum;
+    tree.visit_matches(Queries::within(query),
+                       [&](const auto& node) { expected_sum(node); });
+
+    std::vector<SumVisitor> sums(1U + (i % 4U));
+    tree.visit_matches_parallel(Queries::within(query), sums);
+    SumVisitor total;
+    for (const auto& s : sums) {
+      total.count += s.count;
+      total.sum += s.sum;
+    }
+    CHECK((total.count == expected_count));
+    CHECK((total.sum == expected_sum.sum));
+
     // Incremental query
     count = 0;
     for (const auto& node : tree.query(Queries::within(query))) {
       verify(node);
     }
     CHECK((count == expected_count));
+
+#if SPAIX_USE_COROUTINES
+    // Coroutine query in batches
+    count = 0;
+    for (const auto& batch :
+         tree.template query_batches<3U>(Queries::within(query))) {
+      CHECK(batch.size() > 0U);
+      CHECK(batch.size() <= 3U);
+      for (const auto& node : batch) {
+        verify(node.get());
+      }
+    }
+    CHECK((count == expected_count));
+#endif
+
+    // Budgeted query resumed one node at a time
+    count = 0;
+    typename Tree::Progress progress{};
+    do {
+      spaix::budget::Nodes budget{1U};
+      tree.visit_matches(Queries::within(query), verify, budget, progress);
+      CHECK(!budget.remaining());
+    } while (!progress.complete());
+    CHECK((count == expected_count));
+
+    // Query sorted by the lower bound in a dimension
+    count = 0;
+    std::vector<float> lowers;
+    tree.template visit_matches_sorted<1U>(
+      Queries::within(query), [&](const auto& node) {
+        verify(node);
+        lowers.push_back(Ops::lower<1>(node.first));
+        return spaix::VisitStatus::proceed;
+      });
+    CHECK((count == expected_count));
+    CHECK(std::is_sorted(lowers.begin(), lowers.end()));
+
+    // Sorted query that finishes at the first match
+    count = 0;
+    tree.template visit_matches_sorted<1U>(
+      Queries::within(query), [&](const auto& node) {
+        CHECK(Ops::lower<1>(node.first) == lowers.front());
+        ++count;
+        return spaix::VisitStatus::finish;
+      });
+    CHECK((count == std::min(expected_count, 1U)));
+
+    // Skyline query, which is only the lowest corner of the grid
+    const auto skyline = tree.skyline(Queries::within(query));
+    CHECK(skyline.size() == std::min(expected_count, 1U));
+    for (const auto* const node : skyline) {
+      CHECK((Ops::lower<0>(node->first) == static_cast<float>(x_low)));
+      CHECK((Ops::lower<1>(node->first) == static_cast<float>(y_low)));
+    }
+
+    // Sampled query at a resolution finer than the grid
+    count = 0;
+    tree.visit_matches_sampled(Queries::within(query), 0.5f, verify);
+    CHECK((count == expected_count));
+
+    // Sampled query at a resolution coarser than the whole tree
+    count = 0;
+    tree.visit_matches_sampled(
+      Queries::within(query), static_cast<float>(span) * 2.0f, verify);
+    CHECK((count == std::min(expected_count, 1U)));
+
+    // Sampled query at an intermediate resolution
+    count = 0;
+    std::set<const void*> sampled;
+    tree.visit_matches_sampled(
+      Queries::within(query), 4.0f, [&](const auto& node) {
+        verify(node);
+        CHECK(sampled.emplace(&node).second);
+      });
+    CHECK((count <= expected_count));
+    CHECK((!count == !expected_count));
+
+    // Histogram over the query window
+    const auto cells   = static_cast<size_t>(1U + (i % 5U));
+    const auto to_cell = [cells](const float x, const float l, const float h) {
+      const auto offset = static_cast<double>(x - l);
+      const auto width  = static_cast<double>(h - l);
+      return std::min(
+        static_cast<size_t>(offset / width * static_cast<double>(cells)),
+        cells - 1U);
+    };
+
+    std::vector<size_t> expected_counts(cells * cells);
+    for (const auto& node : tree) {
+      const auto x = Ops::lower<0>(node.first);
+      const auto y = Ops::lower<1>(node.first);
+      if (Comparisons::contains(query, Point{x, y})) {
+        const auto x_cell =
+          to_cell(x, Ops::lower<0>(query), Ops::upper<0>(query));
+        const auto y_cell =
+          to_cell(y, Ops::lower<1>(query), Ops::upper<1>(query));
+        ++expected_counts[(y_cell * cells) + x_cell];
+      }
+    }
+
+    CHECK(tree.histogram(query, cells) == expected_counts);
+
+    // Nearby query starting from a previous result, which may miss some
+    count             = 0;
+    const auto finger = tree.query(Queries::within(query)).begin();
+    const auto nearby = [&](const auto& node) {
+      verify(node);
+      return spaix::VisitStatus::proceed;
+    };
+    tree.visit_nearby(finger, query, Queries::within(query), nearby);
+    CHECK((count <= expected_count));
+    CHECK((count >= std::min(expected_count, 1U)));
+
+    // Nearby query starting from the root, which is complete
+    count = 0;
+    tree.visit_nearby(tree.end(), query, Queries::within(query), nearby);
+    CHECK((count == expected_count));
+  }
+
+  // Test paginating a query with cursors
+  {
+    constexpr size_t page_size = 7U;
+
+    const auto search  = Queries::within(tree.bounds());
+    auto       cursor  = tree.cursor(tree.query(search).begin());
+    size_t     count   = 0U;
+    size_t     n_pages = 0U;
+    while (!cursor.empty()) {
+      auto page = tree.resume(cursor, search);
+      CHECK(page);
+
+      auto i = page->begin();
+      for (size_t n = 0U; n < page_size && i != page->end(); ++n, ++i) {
+        ++count;
+      }
+
+      cursor = tree.cursor(i);
+      ++n_pages;
+    }
+
+    CHECK(count == tree.size());
+    CHECK(n_pages == (tree.size() + page_size - 1U) / page_size);
+  }
+
+  // Test nearby queries that finish at the first match
+  for (auto i = 0U; i < n_queries; ++i) {
+    using Box     = typename Tree::Box;
+    using DatNode = typename Tree::DatNode;
+
+    const auto offset = static_cast<std::ptrdiff_t>(dist(rng) % tree.size());
+
+    const auto     finger = std::next(tree.begin(), offset);
+    const Box      window{finger->first};
+    const DatNode* first  = nullptr;
+    size_t         count  = 0U;
+    const auto     visit  = [&](const auto& node) {
+      first = &node;
+      ++count;
+      return spaix::VisitStatus::finish;
+    };
+
+    size_t n_nearby = 0U;
+    tree.visit_nearby(
+      finger,
+      window,
+      CountingSearch{Queries::exactly(finger->first), &n_nearby},
+      visit);
+
+    CHECK(count == 1U);
+    CHECK(first == &*finger);
+    CHECK(n_nearby == 1U); // Only the leaf
+
+    // Starting at the root checks at least one directory at every level
+    size_t n_root = 0U;
+    tree.visit_nearby(
+      tree.end(),
+      window,
+      CountingSearch{Queries::exactly(finger->first), &n_root},
+      visit);
+
+    CHECK(count == 2U);
+    CHECK(n_root >= tree.height());
+  }
+
+  // Test viewport deltas between consecutive random queries
+  {
+    using KeySet  = std::set<std::tuple<float, float, float, float>>;
+    using DatNode = typename Tree::DatNode;
+
+    const auto key_tuple = [](const Key& key) {
+      return std::make_tuple(Ops::lower<0>(key),
+                             Ops::upper<0>(key),
+                             Ops::lower<1>(key),
+                             Ops::upper<1>(key));
+    };
+
+    const auto random_query = [&]() {
+      const auto range = random_rect();
+      return Queries::within(
+        Rect{{static_cast<Scalar>(range.first.first),
+              static_cast<Scalar>(range.first.second)},
+             {static_cast<Scalar>(range.second.first),
+              static_cast<Scalar>(range.second.second)}});
+    };
+
+    const auto matches = [&](const auto& query) {
+      KeySet keys;
+      tree.visit_matches(query, [&](const DatNode& node) {
+        keys.emplace(key_tuple(node.first));
+      });
+      return keys;
+    };
+
+    auto previous = random_query();
+    for (auto i = 0U; i < n_queries; ++i) {
+      const auto next = random_query();
+
+      KeySet entered;
+      KeySet left;
+      tree.visit_delta(
+        previous,
+        next,
+        [&](const DatNode& node) {
+          CHECK(entered.emplace(key_tuple(node.first)).second);
+        },
+        [&](const DatNode& node) {
+          CHECK(left.emplace(key_tuple(node.first)).second);
+        });
+
+      const auto previous_keys = matches(previous);
+      const auto next_keys     = matches(next);
+
+      KeySet expected_entered;
+      std::set_difference(
+        next_keys.begin(),
+        next_keys.end(),
+        previous_keys.begin(),
+        previous_keys.end(),
+        std::inserter(expected_entered, expected_entered.begin()));
+
+      KeySet expected_left;
+      std::set_difference(previous_keys.begin(),
+                          previous_keys.end(),
+                          next_keys.begin(),
+                          next_keys.end(),
+                          std::inserter(expected_left, expected_left.begin()));
+
+      CHECK(entered == expected_entered);
+      CHECK(left == expected_left);
+
+      previous = next;
+    }
+  }
+
+  // Test a batch of queries run in parallel with indexed results
+  {
+    using Query = decltype(Queries::within(Rect{}));
+
+    std::vector<Query> batch;
+    for (auto i = 0U; i < n_queries; ++i) {
+      const auto range = random_rect();
+      batch.emplace_back(Queries::within(
+        Rect{{static_cast<Scalar>(range.first.first),
+              static_cast<Scalar>(range.first.second)},
+             {static_cast<Scalar>(range.second.first),
+              static_cast<Scalar>(range.second.second)}}));
+    }
+
+    std::vector<size_t> counts(batch.size());
+    auto count_match = [&counts](const size_t q, const auto&) { ++counts[q]; };
+
+    std::vector<decltype(count_match)> visitors(3U, count_match);
+    tree.visit_matches_batch(batch, visitors);
+
+    for (size_t q = 0U; q < batch.size(); ++q) {
+      size_t expected = 0U;
+      tree.visit_matches(batch[q], [&expected](const auto&) { ++expected; });
+      CHECK(counts[q] == expected);
+    }
+  }
+
+  // Test a budgeted query that runs out of time before it starts
+  {
+    using Deadline = spaix::budget::Deadline<std::chrono::steady_clock>;
+
+    const Deadline          expired{std::chrono::steady_clock::now()};
+    typename Tree::Progress progress{};
+    size_t                  n_visited = 0U;
+    tree.visit_matches(
+      Queries::everything(),
+      [&n_visited](const auto&) { ++n_visited; },
+      expired,
+      progress);
+
+    CHECK(!n_visited);
+    CHECK(!progress.complete());
+    CHECK(progress.pending.size() == 1U);
   }
 }
 
@@ -377,6 +777,241 @@ test_tree(const unsigned span, const unsigned n_queries)
 
   test_queries(tree, rng, span, n_queries);
 
+  // Check that a cursor can not be resumed after the tree is modified
+  {
+    const auto cursor = tree.cursor(std::next(tree.begin()));
+    CHECK(cursor.version == tree.version());
+    CHECK(tree.resume(cursor, Queries::everything()));
+
+    auto i = tree.begin();
+    tree.relocate(i, i->first);
+    CHECK(!tree.resume(cursor, Queries::everything()));
+  }
+
+  // Erase items in bulk
+  {
+    auto       bulk      = make_tree<Tree>(rng, span);
+    const auto half      = static_cast<float>(span) / 2.0f;
+    const auto window    = Rect{{0.0f, half}, {0.0f, static_cast<float>(span)}};
+    const auto in_window = [&](const auto& node) {
+      return Comparisons::contains(window, node.first);
+    };
+
+    const auto every_third = [](const auto& node) {
+      return node.second % 3U == 0U;
+    };
+
+    size_t n_expected = 0U;
+    size_t n_kept     = 0U;
+    for (const auto& node : bulk) {
+      const bool erased = in_window(node) && every_third(node);
+      n_expected += erased;
+      n_kept += !erased;
+    }
+
+    CHECK(bulk.erase_if(Queries::within(window), every_third) == n_expected);
+    CHECK(bulk.size() == n_kept);
+    test_structure(bulk);
+    for (const auto& node : bulk) {
+      CHECK(!in_window(node) || !every_third(node));
+    }
+
+    // Erase nearly everything, which empties entire subtrees
+    const auto most = [](const auto& node) { return node.second % 17U; };
+    n_kept          = 0U;
+    for (const auto& node : bulk) {
+      n_kept += !most(node);
+    }
+
+    bulk.erase_if(Queries::everything(), most);
+    CHECK(bulk.size() == n_kept);
+    if (!bulk.empty()) {
+      test_structure(bulk);
+    }
+
+    // Erase everything else
+    const auto all = [](const auto&) { return true; };
+    CHECK(bulk.erase_if(Queries::everything(), all) == n_kept);
+    test_empty_tree(bulk, span);
+  }
+
+  // Erase items without condensing, then compact a few nodes at a time
+  {
+    auto lazy = make_tree<Tree>(rng, span);
+
+    std::vector<Key> erased;
+    for (const auto& node : lazy) {
+      if (node.second % 3U) {
+        erased.emplace_back(node.first);
+      }
+    }
+
+    const auto n_items = lazy.size();
+    for (const auto& key : erased) {
+      auto matches = lazy.query(Queries::exactly(key));
+      auto i       = matches.begin();
+      CHECK(i != matches.end());
+      lazy.erase_deferred(i);
+      CHECK(lazy.query(Queries::exactly(key)).empty());
+    }
+
+    CHECK(lazy.size() == n_items - erased.size());
+    const auto rest = lazy.query(Queries::everything());
+    CHECK(static_cast<size_t>(std::distance(rest.begin(), rest.end())) ==
+          lazy.size());
+
+    // Insert into the uncompacted tree
+    for (size_t i = 0U; i < erased.size(); i += 4U) {
+      lazy.insert(erased[i], i);
+    }
+
+    spaix::budget::Nodes budget{4U};
+    while (!lazy.compact(budget)) {
+      budget = spaix::budget::Nodes{4U};
+    }
+
+    test_structure(lazy);
+
+    // Erase everything else
+    while (!lazy.empty()) {
+      auto i = lazy.begin();
+      lazy.erase_deferred(i);
+    }
+    test_empty_tree(lazy, span);
+  }
+
+  // Repack overlapping subtrees, then the whole tree
+  {
+    auto       packed = make_tree<Tree>(rng, span);
+    const auto height = packed.height();
+
+    packed.optimize(0.25);
+    CHECK(packed.height() == height);
+    test_structure(packed);
+    test_queries(packed, rng, span, n_queries / 4U);
+
+    packed.optimize();
+    CHECK(packed.height() <= height);
+    test_structure(packed);
+    test_queries(packed, rng, span, n_queries / 4U);
+
+    // Repack after erasing most items, which leaves sparse nodes behind
+    std::vector<Data> kept;
+    packed.erase_if(Queries::everything(), [&kept](const auto& node) {
+      if (node.second % 5U) {
+        return true;
+      }
+
+      kept.emplace_back(node.second);
+      return false;
+    });
+
+    packed.optimize();
+    test_structure(packed);
+
+    std::vector<Data> values;
+    for (const auto& node : packed) {
+      values.emplace_back(node.second);
+    }
+
+    std::sort(kept.begin(), kept.end());
+    std::sort(values.begin(), values.end());
+    CHECK(values == kept);
+  }
+
+  // Merge trees of the same height, then smaller and empty trees
+  {
+    auto       merged = make_tree<Tree>(rng, span);
+    auto       other  = make_tree<Tree>(rng, span);
+    const auto n      = merged.size();
+
+    merged.merge(std::move(other));
+    CHECK(merged.size() == 2U * n);
+    test_empty_tree(other, span);
+    test_structure(merged);
+
+    Tree small;
+    for (unsigned i = 0U; i < span; ++i) {
+      small.insert(make_key<Key>(i, i), i);
+    }
+
+    merged.merge(std::move(small));
+    CHECK(merged.size() == (2U * n) + span);
+    test_structure(merged);
+
+    const auto diagonal = merged.query(Queries::exactly(make_key<Key>(0, 0)));
+    CHECK(std::distance(diagonal.begin(), diagonal.end()) == 3U);
+
+    Tree empty;
+    merged.merge(std::move(empty));
+    CHECK(merged.size() == (2U * n) + span);
+
+    empty.merge(std::move(merged));
+    CHECK(empty.size() == (2U * n) + span);
+    test_empty_tree(merged, span);
+    test_structure(empty);
+
+    // Merge a tall tree into a short one
+    Tree single;
+    single.insert(make_key<Key>(0, 0), 0U);
+    single.merge(std::move(empty));
+    CHECK(single.size() == (2U * n) + span + 1U);
+    test_structure(single);
+  }
+
+  // Extract a window into a separate tree, then everything else
+  {
+    auto       source    = make_tree<Tree>(rng, span);
+    const auto n_items   = source.size();
+    const auto third     = static_cast<float>((span / 3U) + 1U);
+    const auto window    = Rect{{third, 2.0f * third}, {0.0f, third}};
+    const auto in_window = [&](const auto& node) {
+      return Comparisons::contains(window, node.first);
+    };
+
+    auto extracted = source.extract(Queries::within(window));
+    CHECK(!extracted.empty());
+    CHECK(extracted.size() + source.size() == n_items);
+    test_structure(extracted);
+    test_structure(source);
+    for (const auto& node : extracted) {
+      CHECK(in_window(node));
+    }
+    for (const auto& node : source) {
+      CHECK(!in_window(node));
+    }
+
+    CHECK(source.extract(Queries::within(window)).empty());
+
+    auto rest = source.extract(Queries::everything());
+    CHECK(rest.size() + extracted.size() == n_items);
+    test_empty_tree(source, span);
+    test_structure(rest);
+  }
+
+  // Adapt to queries that are all near one corner
+  {
+    auto adaptive = make_tree<Tree>(rng, span);
+    CHECK(!adaptive.adapt(0.0));
+
+    const auto corner = static_cast<float>(span) / 4.0f;
+    adaptive.record_visits(true);
+    for (unsigned round = 0U; round < 4U; ++round) {
+      for (unsigned q = 0U; q < n_queries / 4U; ++q) {
+        const auto x      = static_cast<float>(dist(rng)) / 4.0f;
+        const auto y      = static_cast<float>(dist(rng)) / 4.0f;
+        const auto window = Rect{{x, x + corner}, {y, y + corner}};
+        adaptive.visit_matches(Queries::within(window), [](const auto&) {});
+      }
+
+      adaptive.adapt(0.0);
+      test_structure(adaptive);
+    }
+
+    adaptive.record_visits(false);
+    test_queries(adaptive, rng, span, n_queries / 4U);
+  }
+
   // Relocate and remove all elements
   {
     std::vector<unsigned> y_values(span + 1);
@@ -424,6 +1059,534 @@ test_tree(const unsigned span, const unsigned n_queries)
   test_empty_tree(tree, span);
 }
 
+struct Notification {
+  size_t                   id;
+  spaix::SubscriptionEvent event;
+  Data                     data;
+
+  bool operator<(const Notification& rhs) const
+  {
+    return std::tie(id, event, data) < std::tie(rhs.id, rhs.event, rhs.data);
+  }
+
+  bool operator==(const Notification& rhs) const
+  {
+    return std::tie(id, event, data) == std::tie(rhs.id, rhs.event, rhs.data);
+  }
+};
+
+struct NotificationRecorder {
+  template<class DatNode>
+  void operator()(const size_t                   id,
+                  const spaix::SubscriptionEvent event,
+                  const DatNode&                 node) const
+  {
+    notifications->push_back({id, event, node.second});
+  }
+
+  std::vector<Notification>* notifications;
+};
+
+void
+test_subscriptions()
+{
+  using Event = spaix::SubscriptionEvent;
+
+  using Structure =
+    spaix::StaticStructure<4U, 4U, spaix::DataPlacement::inlined>;
+
+  using IndexConf = spaix::
+    Config<Structure, spaix::QuadraticSplit<Ops>, spaix::LinearInsertion<Ops>>;
+
+  using Subscriptions =
+    spaix::Subscriptions<Comparisons, IndexConf, NotificationRecorder>;
+
+  using Tree = spaix::RTree<Rect,
+                            Point,
+                            Data,
+                            spaix::Config<Structure,
+                                          spaix::LinearSplit<Ops, 2U>,
+                                          spaix::LinearInsertion<Ops>,
+                                          spaix::DefaultMinFillRatio,
+                                          Subscriptions>>;
+
+  std::vector<Notification> notifications;
+
+  Tree tree{{}, {}, Subscriptions{NotificationRecorder{&notifications}}};
+
+  const auto check = [&notifications](std::vector<Notification> expected) {
+    std::sort(notifications.begin(), notifications.end());
+    std::sort(expected.begin(), expected.end());
+    CHECK(notifications == expected);
+    notifications.clear();
+  };
+
+  const Rect a_region{{0.0f, 10.0f}, {0.0f, 10.0f}};
+  const Rect b_region{{5.0f, 15.0f}, {5.0f, 15.0f}};
+
+  auto&      subscriptions = tree.observer();
+  const auto a             = subscriptions.subscribe(a_region);
+  const auto b             = subscriptions.subscribe(b_region);
+  CHECK(subscriptions.size() == 2U);
+
+  // Insert an item into only one region
+  tree.insert(Point{1.0f, 1.0f}, 1U);
+  check({{a, Event::entered, 1U}});
+
+  // Insert an item into both regions
+  tree.insert(Point{7.0f, 7.0f}, 2U);
+  check({{a, Event::entered, 2U}, {b, Event::entered, 2U}});
+
+  // Insert an item outside every region
+  tree.insert(Point{20.0f, 20.0f}, 3U);
+  check({});
+
+  // Insert enough items outside every region to make a deeper tree
+  for (auto i = 0U; i < 32U; ++i) {
+    tree.insert(Point{30.0f + static_cast<float>(i), 30.0f}, 100U + i);
+  }
+  check({});
+
+  // Move an item from one region to the other
+  tree.relocate(tree.query(Queries::exactly(Point{1.0f, 1.0f})).begin(),
+                Point{12.0f, 12.0f});
+  check({{a, Event::left, 1U}, {b, Event::entered, 1U}});
+
+  // Move an item within both regions
+  tree.relocate(tree.query(Queries::exactly(Point{7.0f, 7.0f})).begin(),
+                Point{8.0f, 8.0f});
+  check({});
+
+  // Move an item from outside into a region
+  tree.relocate(tree.query(Queries::exactly(Point{20.0f, 20.0f})).begin(),
+                Point{2.0f, 2.0f});
+  check({{a, Event::entered, 3U}});
+
+  // Erase an item in both regions
+  tree.erase(tree.query(Queries::exactly(Point{8.0f, 8.0f})).begin());
+  check({{a, Event::left, 2U}, {b, Event::left, 2U}});
+
+  // Unsubscribe and check that only the remaining subscription is notified
+  CHECK(!subscriptions.unsubscribe(a_region, b));
+  CHECK(subscriptions.unsubscribe(b_region, b));
+  CHECK(!subscriptions.unsubscribe(b_region, b));
+  CHECK(subscriptions.size() == 1U);
+  tree.insert(Point{9.0f, 9.0f}, 4U);
+  check({{a, Event::entered, 4U}});
+}
+
+void
+test_query_cache()
+{
+  using Structure =
+    spaix::StaticStructure<4U, 4U, spaix::DataPlacement::inlined>;
+
+  using Cache = spaix::QueryCache<Comparisons, Point, Data>;
+
+  using Tree = spaix::RTree<Rect,
+                            Point,
+                            Data,
+                            spaix::Config<Structure,
+                                          spaix::LinearSplit<Ops, 2U>,
+                                          spaix::LinearInsertion<Ops>,
+                                          spaix::DefaultMinFillRatio,
+                                          Cache>>;
+
+  Tree tree{{}, {}, Cache{2U}};
+  for (auto x = 0U; x < 16U; ++x) {
+    for (auto y = 0U; y < 16U; ++y) {
+      tree.insert(make_key<Point>(x, y), (x * 16U) + y);
+    }
+  }
+
+  auto&      cache = tree.observer();
+  const Rect a{{0.0f, 3.0f}, {0.0f, 3.0f}};
+  const Rect b{{8.0f, 9.0f}, {8.0f, 9.0f}};
+  const Rect c{{12.0f, 15.0f}, {0.0f, 1.0f}};
+
+  // Query a window twice and check that the second is answered by the cache
+  CHECK(cache.query(tree, a).size() == 16U);
+  CHECK(cache.query(tree, a).size() == 16U);
+  CHECK(cache.stats().misses == 1U);
+  CHECK(cache.stats().hits == 1U);
+  CHECK(cache.stats().memory >= 16U * sizeof(Tree::DatNode));
+
+  // Insert an item elsewhere and check that the entry is still valid
+  size_t count = 0U;
+  tree.insert(Point{20.0f, 20.0f}, 1000U);
+  cache.visit_matches(tree, a, [&count](const auto&) { ++count; });
+  CHECK(count == 16U);
+  CHECK(cache.stats().hits == 2U);
+  CHECK(!cache.stats().invalidations);
+
+  // Insert an item into the window and check that the entry is invalidated
+  tree.insert(Point{1.5f, 1.5f}, 1001U);
+  CHECK(cache.stats().invalidations == 1U);
+  CHECK(cache.query(tree, a).size() == 17U);
+  CHECK(cache.stats().misses == 2U);
+
+  // Move an item out of the window and check that the entry is invalidated
+  tree.relocate(tree.query(Queries::exactly(Point{1.5f, 1.5f})).begin(),
+                Point{21.0f, 21.0f});
+  CHECK(cache.stats().invalidations == 2U);
+  CHECK(cache.query(tree, a).size() == 16U);
+
+  // Fill the cache and check that the least recently used entry is evicted
+  CHECK(cache.query(tree, b).size() == 4U);
+  CHECK(cache.query(tree, a).size() == 16U);
+  CHECK(cache.query(tree, c).size() == 8U);
+  CHECK(cache.size() == 2U);
+  CHECK(cache.stats().evictions == 1U);
+  CHECK(cache.query(tree, a).size() == 16U);
+  CHECK(cache.stats().evictions == 1U);
+
+  // Erase an item and check that only the affected entry is invalidated
+  tree.erase(tree.query(Queries::exactly(make_key<Point>(0U, 0U))).begin());
+  CHECK(cache.stats().invalidations == 3U);
+  CHECK(cache.size() == 1U);
+
+  // Clear the tree and check that every entry is invalidated
+  tree.clear();
+  CHECK(!cache.size());
+  CHECK(cache.query(tree, c).empty());
+  CHECK(cache.stats().hit_rate() > 0.0);
+  CHECK(cache.stats().hit_rate() < 1.0);
+}
+
+void
+test_skyline()
+{
+  using Point3 = spaix::homox::Point<float, 3U>;
+  using Rect3  = spaix::homox::Rect<float, 3U>;
+  using Ops3   = spaix::homox::Operations<float, 3U>;
+  using Comps3 = spaix::homox::Comparisons<float, 3U>;
+
+  using Structure =
+    spaix::StaticStructure<8U, 8U, spaix::DataPlacement::inlined>;
+
+  using Tree = spaix::RTree<Rect3,
+                            Point3,
+                            Data,
+                            spaix::Config<Structure,
+                                          spaix::LinearSplit<Ops3, 3U>,
+                                          spaix::LinearInsertion<Ops3>>>;
+
+  std::mt19937                            rng{std::random_device{}()};
+  std::uniform_int_distribution<unsigned> dist{0U, 31U};
+
+  const auto coord = [&]() { return static_cast<float>(dist(rng)); };
+
+  Tree tree;
+  for (Data i = 0U; i < 1000U; ++i) {
+    tree.insert(Point3{coord(), coord(), coord()}, i);
+  }
+
+  const auto dominates = [](const Point3& lhs, const Point3& rhs) {
+    return lhs[0] <= rhs[0] && lhs[1] <= rhs[1] && lhs[2] <= rhs[2] &&
+           lhs != rhs;
+  };
+
+  const auto check_skyline = [&](const auto& search) {
+    std::set<Data> expected;
+    tree.visit_matches(search, [&](const Tree::DatNode& node) {
+      bool is_dominated = false;
+      tree.visit_matches(search, [&](const Tree::DatNode& other) {
+        is_dominated = is_dominated || dominates(other.first, node.first);
+      });
+
+      if (!is_dominated) {
+        expected.emplace(node.second);
+      }
+    });
+
+    std::set<Data> actual;
+    for (const auto* const node : tree.skyline(search)) {
+      CHECK(actual.emplace(node->second).second);
+    }
+
+    CHECK(!expected.empty());
+    CHECK(actual == expected);
+  };
+
+  check_skyline(spaix::search::Everything{});
+  check_skyline(
+    spaix::Queries<Comps3>::within(Rect3{spaix::make_dim_range(8.0f, 24.0f),
+                                         spaix::make_dim_range(8.0f, 24.0f),
+                                         spaix::make_dim_range(8.0f, 24.0f)}));
+}
+
+/// A summary of the category of data, which is the data modulo 8
+struct CategorySummary {
+  using Mask = uint8_t;
+
+  static Mask summarize(const Data& data) noexcept
+  {
+    return static_cast<Mask>(1U << (data % 8U));
+  }
+};
+
+/// A query for items within a window that are in a set of categories
+struct CategoryWithin {
+  template<class DirKey>
+  [[nodiscard]] bool directory(const DirKey& k) const
+  {
+    ++*n_checked_dirs;
+    return window.directory(k);
+  }
+
+  template<class DatKey>
+  [[nodiscard]] bool leaf(const DatKey& k) const
+  {
+    return window.leaf(k);
+  }
+
+  [[nodiscard]] bool summary(const CategorySummary::Mask mask) const
+  {
+    return mask & categories;
+  }
+
+  spaix::search::Within<Comparisons, Rect> window;
+  CategorySummary::Mask                    categories;
+  size_t*                                  n_checked_dirs;
+};
+
+void
+test_summary()
+{
+  using Structure =
+    spaix::StaticStructure<4U, 4U, spaix::DataPlacement::inlined>;
+
+  using Tree = spaix::RTree<Rect,
+                            Point,
+                            Data,
+                            spaix::Config<Structure,
+                                          spaix::LinearSplit<Ops, 2U>,
+                                          spaix::LinearInsertion<Ops>,
+                                          spaix::DefaultMinFillRatio,
+                                          spaix::NullObserver,
+                                          CategorySummary>>;
+
+  // Make a tree where category 7 is rare and the rest are common
+  Tree tree;
+  for (auto x = 0U; x < 32U; ++x) {
+    for (auto y = 0U; y < 32U; ++y) {
+      const Data data = (x % 4U == 0U && y % 4U == 0U) ? 7U : (x + y) % 7U;
+      tree.insert(make_key<Point>(x, y), data);
+    }
+  }
+
+  const auto window = Rect{{0.0f, 31.0f}, {0.0f, 31.0f}};
+  const auto query  = [&](const uint8_t categories, size_t* n_checked_dirs) {
+    std::vector<Data> results;
+    tree.visit_matches(
+      CategoryWithin{Queries::within(window), categories, n_checked_dirs},
+      [&results](const Tree::DatNode& node) {
+        results.push_back(node.second);
+      });
+    return results;
+  };
+
+  // Check that a rare category is found while checking fewer directories
+  size_t n_rare_dirs = 0U;
+  size_t n_all_dirs  = 0U;
+  CHECK(query(0x80U, &n_rare_dirs).size() == 64U);
+  CHECK(query(0xFFU, &n_all_dirs).size() == tree.size());
+  CHECK(n_rare_dirs < n_all_dirs);
+
+  // Check that iterator queries give the same results
+  size_t n_iter_dirs = 0U;
+  size_t n_iterated  = 0U;
+  for (const auto& node : tree.query(
+         CategoryWithin{Queries::within(window), 0x80U, &n_iter_dirs})) {
+    CHECK(node.second == 7U);
+    ++n_iterated;
+  }
+  CHECK(n_iterated == 64U);
+
+  // Check that delta queries between categories in the same window differ
+  size_t n_delta_dirs = 0U;
+  size_t n_entered    = 0U;
+  size_t n_left       = 0U;
+  tree.visit_delta(
+    CategoryWithin{Queries::within(window), 0x80U, &n_delta_dirs},
+    CategoryWithin{Queries::within(window), 0x7FU, &n_delta_dirs},
+    [&n_entered](const Tree::DatNode& node) {
+      CHECK(node.second != 7U);
+      ++n_entered;
+    },
+    [&n_left](const Tree::DatNode& node) {
+      CHECK(node.second == 7U);
+      ++n_left;
+    });
+  CHECK(n_entered == tree.size() - 64U);
+  CHECK(n_left == 64U);
+
+  // Erase every rare item and check that only the root is checked
+  for (auto x = 0U; x < 32U; x += 4U) {
+    for (auto y = 0U; y < 32U; y += 4U) {
+      tree.erase(tree.query(Queries::exactly(make_key<Point>(x, y))).begin());
+    }
+  }
+
+  n_rare_dirs = 0U;
+  CHECK(query(0x80U, &n_rare_dirs).empty());
+  CHECK(n_rare_dirs == 1U);
+  CHECK(query(0x7FU, &n_all_dirs).size() == tree.size());
+
+  // Check that extracting from a covering window only moves one category
+  const auto n_total = tree.size();
+  size_t     n_zeros = 0U;
+  for (const auto& node : tree) {
+    n_zeros += (node.second == 0U);
+  }
+
+  const auto zeros =
+    tree.extract(CategoryWithin{Queries::within(window), 0x01U, &n_all_dirs});
+  CHECK(zeros.size() == n_zeros);
+  CHECK(tree.size() == n_total - n_zeros);
+  for (const auto& node : zeros) {
+    CHECK(node.second == 0U);
+  }
+  for (const auto& node : tree) {
+    CHECK(node.second != 0U);
+  }
+}
+
+template<spaix::DataPlacement placement>
+void
+test_handles()
+{
+  using Structure = spaix::StaticStructure<4U, 4U, placement>;
+  using Handles   = spaix::HandleTable<Data>;
+  using Tree      = spaix::RTree<Rect,
+                            Point,
+                            Data,
+                            spaix::Config<Structure,
+                                          spaix::LinearSplit<Ops, 2U>,
+                                          spaix::LinearInsertion<Ops>,
+                                          spaix::DefaultMinFillRatio,
+                                          Handles>>;
+
+  std::mt19937                          rng{5489U};
+  std::uniform_real_distribution<float> dist{0.0f, 100.0f};
+  std::uniform_real_distribution<float> nudge{-1.0f, 1.0f};
+
+  const auto check_handles = [](Tree& tree) {
+    CHECK(tree.observer().size() == tree.size());
+    for (const auto& node : tree) {
+      const auto* const handle = tree.observer().find(node.second);
+      CHECK(handle);
+      CHECK(&*tree.locate(*handle) == &node);
+    }
+
+    test_structure(tree);
+  };
+
+  // Insert items and check that every handle refers to its item
+  Tree tree;
+  for (Data id = 0U; id < 500U; ++id) {
+    tree.insert(Point{dist(rng), dist(rng)}, id);
+  }
+  check_handles(tree);
+
+  // Move items by a small amount, then far away, by ID
+  for (Data id = 0U; id < 500U; ++id) {
+    const auto& handle = *tree.observer().find(id);
+    const auto  i      = tree.locate(handle);
+    const auto  x      = Ops::lower<0>(i->first) + nudge(rng);
+    const auto  y      = Ops::lower<1>(i->first) + nudge(rng);
+
+    tree.relocate(handle, Point{x, y});
+    CHECK(tree.query(Queries::exactly(Point{x, y})).begin()->second == id);
+  }
+  check_handles(tree);
+
+  for (Data id = 0U; id < 500U; id += 2U) {
+    tree.relocate(*tree.observer().find(id), Point{dist(rng), dist(rng)});
+  }
+  check_handles(tree);
+
+  // Move items around within loose bounds, and occasionally beyond them
+  const auto around = [](const Point& p, const float slack) {
+    const auto x = Ops::lower<0>(p);
+    const auto y = Ops::lower<1>(p);
+    return Rect{{x - slack, x + slack}, {y - slack, y + slack}};
+  };
+
+  Tree loose;
+  for (Data id = 0U; id < 500U; ++id) {
+    const auto key = Point{dist(rng), dist(rng)};
+    loose.insert(key, id, around(key, 2.0f));
+  }
+  check_handles(loose);
+
+  for (unsigned step = 0U; step < 8U; ++step) {
+    for (Data id = 0U; id < 500U; ++id) {
+      const auto& handle = *loose.observer().find(id);
+      auto        i      = loose.locate(handle);
+      const auto  x      = Ops::lower<0>(i->first) + nudge(rng) * 2.0f;
+      const auto  y      = Ops::lower<1>(i->first) + nudge(rng) * 2.0f;
+      const auto  key    = Point{x, y};
+
+      loose.relocate(i, key, around(key, 2.0f));
+      CHECK(i->first == key);
+      CHECK(i->second == id);
+      CHECK(loose.query(Queries::exactly(key)).begin()->second == id);
+    }
+    check_handles(loose);
+  }
+
+  // Erase items by ID, one at a time then in bulk
+  for (Data id = 0U; id < 500U; id += 3U) {
+    auto i = tree.locate(*tree.observer().find(id));
+    tree.erase(i);
+    CHECK(!tree.observer().find(id));
+  }
+  check_handles(tree);
+
+  tree.erase_if(Queries::everything(),
+                [](const auto& node) { return node.second % 5U == 0U; });
+  check_handles(tree);
+
+  // Repack trees, which moves every item to a new leaf
+  loose.optimize(0.0);
+  check_handles(loose);
+
+  tree.optimize();
+  check_handles(tree);
+
+  // Adapt to queries, which moves items in leaves that are re-split or merged
+  loose.record_visits(true);
+  for (unsigned q = 0U; q < 100U; ++q) {
+    const auto x = dist(rng) / 4.0f;
+    const auto y = dist(rng) / 4.0f;
+    loose.visit_matches(Queries::within(Rect{{x, x + 5.0f}, {y, y + 5.0f}}),
+                        [](const auto&) {});
+  }
+
+  CHECK(loose.adapt(0.0));
+  check_handles(loose);
+
+  // Merge trees, which moves handles from one table to the other
+  Tree other;
+  for (Data id = 1000U; id < 1100U; ++id) {
+    other.insert(Point{dist(rng), dist(rng)}, id);
+  }
+
+  const auto n_items = tree.size() + other.size();
+  tree.merge(std::move(other));
+  CHECK(tree.size() == n_items);
+  CHECK(!other.observer().size());
+  check_handles(tree);
+
+  // Extract a region, which moves handles to the new tree's table
+  const auto half   = Rect{{0.0f, 50.0f}, {0.0f, 50.0f}};
+  auto       region = tree.extract(Queries::within(half));
+  CHECK(region.size() + tree.size() == n_items);
+  check_handles(tree);
+  check_handles(region);
+}
+
 template<class Key, spaix::DataPlacement placement, unsigned fanout>
 void
 test_fanout(const unsigned span, const unsigned n_queries)
@@ -462,6 +1625,18 @@ test_fanout(const unsigned span, const unsigned n_queries)
                                        spaix::QuadraticSplit<Ops>,
                                        spaix::LinearInsertion<Ops>>>>(
     span, n_queries);
+
+  test_tree<spaix::RTree<Rect,
+                         Key,
+                         Data,
+                         spaix::Config<Structure,
+                                       spaix::QuadraticSplit<Ops>,
+                                       spaix::LinearInsertion<Ops>,
+                                       spaix::DefaultMinFillRatio,
+                                       spaix::NullObserver,
+                                       spaix::NullSummary,
+                                       spaix::MergeUnderflow<Ops>>>>(
+    span, n_queries);
 }
 
 template<class Key, spaix::DataPlacement placement>
@@ -495,6 +1670,12 @@ main(int argc, char** argv)
     const auto span    = static_cast<unsigned>(std::stoul(args.at("span")));
     const auto queries = static_cast<unsigned>(std::stoul(args.at("queries")));
 
+    test_subscriptions();
+    test_query_cache();
+    test_skyline();
+    test_summary();
+    test_handles<spaix::DataPlacement::inlined>();
+    test_handles<spaix::DataPlacement::separate>();
     test_key<spaix::heterox::Point<float, float>>(span, queries);
     test_key<spaix::heterox::Rect<float, float>>(span, queries);
   } catch (const std::exception& e) {
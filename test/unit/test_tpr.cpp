@@ -0,0 +1,174 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <spaix/Config.hpp>
+#include <spaix/DataPlacement.hpp>
+#include <spaix/LinearInsertion.hpp>
+#include <spaix/LinearSplit.hpp>
+#include <spaix/QuadraticSplit.hpp>
+#include <spaix/Queries.hpp>
+#include <spaix/RTree.hpp>
+#include <spaix/homox/Rect.hpp>
+#include <spaix/tpr/Comparisons.hpp>
+#include <spaix/tpr/Operations.hpp>
+#include <spaix/tpr/Point.hpp>
+#include <spaix/tpr/Rect.hpp>
+#include <spaix/tpr/Timeslice.hpp>
+#include <spaix/types.hpp>
+
+#undef NDEBUG
+
+#include <spaix_test/check.hpp>
+
+#include <cstddef>
+#include <random>
+#include <ratio>
+#include <vector>
+
+namespace spaix::test {
+namespace {
+
+using Scalar      = double;
+using Point       = tpr::Point<Scalar, 2U>;
+using Rect        = tpr::Rect<Scalar, 2U>;
+using Motion      = tpr::Motion<Scalar>;
+using MotionRange = tpr::MotionRange<Scalar>;
+using Timeslice   = tpr::Timeslice<Scalar, 2U>;
+using Region      = homox::Rect<Scalar, 2U>;
+using Range       = DimRange<Scalar>;
+using Comparisons = tpr::Comparisons<Scalar, 2U>;
+using Ops         = tpr::Operations<Scalar, 2U, std::ratio<2>>;
+using Queries     = spaix::Queries<Comparisons>;
+
+constexpr void
+test_geometry()
+{
+  constexpr auto a = Point{Motion{1.0, 1.0}, Motion{0.0, 0.0}};
+  constexpr auto b = Point{Motion{3.0, -1.0}, Motion{1.0, 0.0}};
+  constexpr auto r = Ops::unify(Ops::unify(Rect{}, a), b);
+
+  // Bounds use the extreme positions and velocities in each dimension
+  STATIC_CHECK((r == Rect{MotionRange{{1.0, 3.0}, {-1.0, 1.0}},
+                          MotionRange{{0.0, 1.0}, {0.0, 0.0}}}));
+
+  // Both points stay within the bounds as they move
+  for (const auto t : {0.0, 0.5, 1.0, 4.0}) {
+    const auto x = r[0].at(t);
+    CHECK(x.lower <= a[0].at(t) && a[0].at(t) <= x.upper);
+    CHECK(x.lower <= b[0].at(t) && b[0].at(t) <= x.upper);
+  }
+
+  // Static volume is the area times the horizon
+  STATIC_CHECK((Ops::volume(Rect{MotionRange{{0.0, 2.0}, {0.0, 0.0}},
+                                 MotionRange{{0.0, 3.0}, {0.0, 0.0}}}) ==
+                12.0));
+
+  // Growing volume is integrated: the integral of (1 + t) * 1 over [0, 2]
+  STATIC_CHECK((Ops::volume(Rect{MotionRange{{0.0, 1.0}, {0.0, 1.0}},
+                                 MotionRange{{0.0, 1.0}, {0.0, 0.0}}}) ==
+                4.0));
+
+  // Points and empty rects have no volume
+  STATIC_CHECK((Ops::volume(Rect{a}) == 0.0));
+  STATIC_CHECK((Ops::volume(Rect{}) == 0.0));
+
+  // Points are observed at a time relative to time zero
+  STATIC_CHECK((Point::observed(2.0, {Motion{3.0, 1.0}, Motion{0.0, -1.0}}) ==
+                Point{Motion{1.0, 1.0}, Motion{2.0, -1.0}}));
+
+  // Timeslices compare keys at the query time
+  constexpr auto region = Region{Range{0.0, 1.5}, Range{-1.0, 1.0}};
+  constexpr auto early  = Timeslice{0.0, region};
+  constexpr auto later  = Timeslice{2.0, region};
+  STATIC_CHECK((Comparisons::contains(early, a)));
+  STATIC_CHECK((!Comparisons::contains(later, a)));
+  STATIC_CHECK((Comparisons::contains(later, b)));
+  STATIC_CHECK((Comparisons::intersects(later, r)));
+  STATIC_CHECK((!Comparisons::contains(later, r)));
+  STATIC_CHECK((Comparisons::intersects(r, a)));
+  STATIC_CHECK((!Comparisons::intersects(Rect{a}, b)));
+
+  // Timeslices only overlap other timeslices at the same time
+  STATIC_CHECK((Comparisons::contains(early, early)));
+  STATIC_CHECK((Comparisons::intersects(early, early)));
+  STATIC_CHECK((!Comparisons::contains(early, later)));
+  STATIC_CHECK((!Comparisons::intersects(early, later)));
+}
+
+template<class Split>
+void
+test_tree(const size_t n_items, const size_t n_queries)
+{
+  using Structure = spaix::StaticStructure<8U, 8U, DataPlacement::inlined>;
+  using Tree      = spaix::RTree<
+    Rect,
+    Point,
+    size_t,
+    spaix::Config<Structure, Split, spaix::LinearInsertion<Ops>>>;
+
+  std::mt19937                           rng{5489U};
+  std::uniform_real_distribution<Scalar> position{0.0, 100.0};
+  std::uniform_real_distribution<Scalar> velocity{-1.0, 1.0};
+  std::uniform_real_distribution<Scalar> time{0.0, 10.0};
+
+  // Index objects that were observed at various times
+  Tree               tree;
+  std::vector<Point> points;
+  for (size_t i = 0U; i < n_items; ++i) {
+    const auto point =
+      Point::observed(time(rng),
+                      {Motion{position(rng), velocity(rng)},
+                       Motion{position(rng), velocity(rng)}});
+
+    tree.insert(point, i);
+    points.emplace_back(point);
+  }
+
+  // Check that timeslice queries match a brute force search
+  for (size_t q = 0U; q < n_queries; ++q) {
+    const auto x      = position(rng);
+    const auto y      = position(rng);
+    const auto region = Region{Range{x, x + 20.0}, Range{y, y + 20.0}};
+    const auto slice  = Timeslice{time(rng), region};
+
+    std::vector<bool> found(n_items);
+    for (const auto& node : tree.query(Queries::within(slice))) {
+      CHECK(Comparisons::contains(slice, node.first));
+      CHECK(!found[node.second]);
+      found[node.second] = true;
+    }
+
+    for (size_t i = 0U; i < n_items; ++i) {
+      CHECK(found[i] == Comparisons::contains(slice, points[i]));
+    }
+  }
+
+  // Check that items can be found and erased exactly
+  for (size_t i = 0U; i < n_items; i += 2U) {
+    auto range = tree.query(Queries::exactly(points[i]));
+    CHECK(range.begin() != range.end());
+    CHECK(range.begin()->second == i);
+
+    tree.erase(range.begin());
+  }
+
+  CHECK(tree.size() == n_items / 2U);
+}
+
+void
+run()
+{
+  test_geometry();
+  test_tree<spaix::LinearSplit<Ops, 2U>>(1000U, 100U);
+  test_tree<spaix::QuadraticSplit<Ops>>(1000U, 100U);
+}
+
+} // namespace
+} // namespace spaix::test
+
+int
+main()
+{
+  spaix::test::run();
+  return 0;
+}